@@ -54,6 +54,7 @@ BOOST_PYTHON_MODULE(bundle)
             .def("getConfigurationPathsForTaskModel",
 				 &Bundle::getConfigurationPathsForTaskModel)
             .def("findFileByName", &Bundle::findFileByName)
+            .def("tryFindFileByName", &Bundle::tryFindFileByName)
             .def("findFilesByName", &Bundle::findFilesByName)
             .def("findFilesByExtension", &Bundle::findFilesByExtension)
 			.def_readonly("taskConfigurations", &Bundle::taskConfigurations);
@@ -0,0 +1,351 @@
+#include "AccessTracker.hpp"
+#include "Configuration.hpp"
+#include "JsonUtils.hpp"
+#include <mutex>
+#include <memory>
+#include <set>
+#include <unordered_map>
+#include <fstream>
+#include <sstream>
+#include <stdlib.h>
+#include <unistd.h>
+#include <base-logging/Logging.hpp>
+
+using namespace libConfig;
+
+std::atomic<bool> AccessTracker::enabled(false);
+
+namespace
+{
+struct Request
+{
+    std::string taskModelName;
+    std::vector<std::string> sections;
+};
+
+struct Registration
+{
+    std::shared_ptr<const Request> request;
+    std::string path;
+};
+
+typedef std::map<std::string, std::map<std::string, std::vector<std::string> > > SectionPaths;
+
+//Holds the recorded accesses and writes the report on exit if
+//LIB_CONFIG_ACCESS_LOG is set
+struct TrackerState
+{
+    std::mutex mutex;
+    //Values of the configurations returned while tracking
+    std::unordered_map<const ConfigValue*, Registration> values;
+    std::set<std::string> loadedTaskModels;
+    //Property paths of each section of the requested task models, parents
+    //before their children
+    SectionPaths sectionPaths;
+    std::set<std::pair<std::string, std::string> > requestedSections;
+    //Used property paths by task model and section
+    std::map<std::string, std::map<std::string, std::set<std::string> > > used;
+    std::string outputPath;
+
+    TrackerState()
+    {
+        const char* path = getenv("LIB_CONFIG_ACCESS_LOG");
+        if(path && path[0] != '\0'){
+            outputPath = path;
+            std::string::size_type pos = outputPath.find("%p");
+            if(pos != std::string::npos){
+                outputPath.replace(pos, 2, std::to_string(getpid()));
+            }
+            AccessTracker::setEnabled(true);
+        }
+    }
+
+    ~TrackerState();
+
+    AccessReport report();
+};
+
+TrackerState& state()
+{
+    static TrackerState instance;
+    return instance;
+}
+
+//Makes sure LIB_CONFIG_ACCESS_LOG is evaluated when the library is loaded
+const TrackerState& initState = state();
+
+//Set while the tracker itself walks a configuration, so that its reads are
+//not recorded
+thread_local bool walking = false;
+
+struct WalkGuard
+{
+    WalkGuard() { walking = true; }
+    ~WalkGuard() { walking = false; }
+};
+
+std::string childPath(const std::string& parent, const std::string& key)
+{
+    return parent.empty() ? key : parent + "." + key;
+}
+
+std::string parentPath(const std::string& path)
+{
+    std::string::size_type pos = path.rfind('.');
+    return pos == std::string::npos ? std::string() : path.substr(0, pos);
+}
+
+//Calls fn(value, path) for the value and every value below it. Array
+//elements have the path of their array.
+template <class Fn>
+void walk(const ConfigValue& value, const std::string& path, Fn& fn)
+{
+    fn(value, path);
+    if(value.getType() == ConfigValue::COMPLEX){
+        for(const auto& it : static_cast<const ComplexConfigValue&>(value).getValues()){
+            walk(*it.second, childPath(path, it.first), fn);
+        }
+    }else if(value.getType() == ConfigValue::ARRAY){
+        for(const auto& element : static_cast<const ArrayConfigValue&>(value).getValues())
+        {
+            if(element->getType() == ConfigValue::SIMPLE){
+                fn(*element, path);
+            }else{
+                //Nested maps and lists add their own keys
+                walk(*element, path, fn);
+            }
+        }
+    }
+}
+
+template <class Fn>
+void walk(const Configuration& config, Fn& fn)
+{
+    for(const auto& it : config.getValues()){
+        walk(*it.second, it.first, fn);
+    }
+}
+
+std::vector<std::string> propertyPaths(const Configuration& config)
+{
+    std::vector<std::string> paths;
+    std::set<std::string> seen;
+    auto collect = [&](const ConfigValue&, const std::string& path){
+        if(seen.insert(path).second){
+            paths.push_back(path);
+        }
+    };
+    walk(config, collect);
+    return paths;
+}
+
+bool writeReportFile(const AccessReport& report, const std::string& path)
+{
+    std::ofstream out(path.c_str());
+    if(!out){
+        LOG_ERROR_S << "Could not write access report " << path;
+        return false;
+    }
+    out << report.toYaml();
+    return out.good();
+}
+
+TrackerState::~TrackerState()
+{
+    //Values destroyed after this must not touch the state
+    AccessTracker::setEnabled(false);
+    if(!outputPath.empty()){
+        writeReportFile(report(), outputPath);
+    }
+}
+
+AccessReport TrackerState::report()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    AccessReport ret;
+    for(const std::string& task : loadedTaskModels){
+        if(!sectionPaths.count(task)){
+            ret.unusedTaskModels.push_back(task);
+        }
+    }
+    for(const auto& task : sectionPaths)
+    {
+        for(const auto& section : task.second)
+        {
+            if(!requestedSections.count(std::make_pair(task.first, section.first))){
+                ret.unusedSections[task.first].push_back(section.first);
+                continue;
+            }
+            const std::set<std::string>& usedPaths = used[task.first][section.first];
+            for(const std::string& path : section.second)
+            {
+                ret.properties++;
+                if(usedPaths.count(path)){
+                    ret.usedProperties++;
+                    continue;
+                }
+                std::string parent = parentPath(path);
+                if(parent.empty() || usedPaths.count(parent)){
+                    ret.unusedProperties[task.first][section.first].push_back(path);
+                }
+            }
+        }
+    }
+    return ret;
+}
+}
+
+AccessReport::AccessReport() :
+    properties(0), usedProperties(0)
+{
+}
+
+std::string AccessReport::toYaml() const
+{
+    //Written by hand, the report is also written while static objects of
+    //yaml-cpp are destroyed at exit. Strings are quoted as JSON, which is
+    //valid YAML.
+    std::stringstream ss;
+    ss << "properties: " << properties << "\n";
+    ss << "used_properties: " << usedProperties << "\n";
+    ss << "unused_task_models:" << (unusedTaskModels.empty() ? " []\n" : "\n");
+    for(const std::string& task : unusedTaskModels){
+        ss << "  - " << jsonString(task) << "\n";
+    }
+    ss << "unused_sections:" << (unusedSections.empty() ? " {}\n" : "\n");
+    for(const auto& it : unusedSections)
+    {
+        ss << "  " << jsonString(it.first) << ": [";
+        for(size_t i = 0; i < it.second.size(); i++){
+            ss << (i ? ", " : "") << jsonString(it.second[i]);
+        }
+        ss << "]\n";
+    }
+    ss << "unused_properties:" << (unusedProperties.empty() ? " {}\n" : "\n");
+    for(const auto& task : unusedProperties)
+    {
+        ss << "  " << jsonString(task.first) << ":\n";
+        for(const auto& section : task.second)
+        {
+            ss << "    " << jsonString(section.first) << ":\n";
+            for(const std::string& path : section.second){
+                ss << "      - " << jsonString(path) << "\n";
+            }
+        }
+    }
+    return ss.str();
+}
+
+void AccessTracker::setEnabled(bool enable)
+{
+    enabled.store(enable);
+    if(!enable){
+        //Addresses of values destroyed from now on could be reused
+        TrackerState& s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.values.clear();
+    }
+}
+
+void AccessTracker::reset()
+{
+    TrackerState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.values.clear();
+    s.loadedTaskModels.clear();
+    s.sectionPaths.clear();
+    s.requestedSections.clear();
+    s.used.clear();
+}
+
+AccessReport AccessTracker::getReport()
+{
+    return state().report();
+}
+
+bool AccessTracker::writeReport(const std::string &path)
+{
+    return writeReportFile(getReport(), path);
+}
+
+void AccessTracker::taskModelsLoaded(const std::vector<std::string> &taskModelNames)
+{
+    TrackerState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.loadedTaskModels.insert(taskModelNames.begin(), taskModelNames.end());
+}
+
+void AccessTracker::configRequested(const MultiSectionConfiguration &source,
+                                    const std::vector<std::string> &sections,
+                                    const Configuration &result)
+{
+    WalkGuard guard;
+    TrackerState& s = state();
+    std::shared_ptr<Request> request = std::make_shared<Request>();
+    request->taskModelName = source.taskModelName;
+    request->sections = sections;
+
+    std::vector<std::pair<const ConfigValue*, std::string> > registrations;
+    auto collect = [&](const ConfigValue& value, const std::string& path){
+        registrations.push_back(std::make_pair(&value, path));
+    };
+    walk(result, collect);
+
+    bool known;
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        known = s.sectionPaths.count(source.taskModelName) > 0;
+    }
+    std::map<std::string, std::vector<std::string> > paths;
+    if(!known){
+        for(const auto& it : source.getSubsections()){
+            paths[it.first] = propertyPaths(it.second);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(s.mutex);
+    for(const auto& it : registrations){
+        Registration& registration = s.values[it.first];
+        registration.request = request;
+        registration.path = it.second;
+    }
+    if(!known){
+        s.sectionPaths.emplace(source.taskModelName, paths);
+    }
+    s.loadedTaskModels.insert(source.taskModelName);
+    for(const std::string& section : sections){
+        s.requestedSections.insert(std::make_pair(source.taskModelName, section));
+    }
+}
+
+void AccessTracker::valueRead(const ConfigValue *value)
+{
+    if(walking){
+        return;
+    }
+    TrackerState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    std::unordered_map<const ConfigValue*, Registration>::const_iterator it = s.values.find(value);
+    if(it == s.values.end()){
+        return;
+    }
+    const Request& request = *it->second.request;
+    std::map<std::string, std::set<std::string> >& used = s.used[request.taskModelName];
+    for(const std::string& section : request.sections)
+    {
+        std::set<std::string>& usedPaths = used[section];
+        for(std::string path = it->second.path; !path.empty(); path = parentPath(path)){
+            if(!usedPaths.insert(path).second){
+                //The parents were marked before
+                break;
+            }
+        }
+    }
+}
+
+void AccessTracker::valueDestroyed(const ConfigValue *value)
+{
+    TrackerState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.values.erase(value);
+}
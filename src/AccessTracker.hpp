@@ -0,0 +1,86 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <atomic>
+
+namespace libConfig
+{
+
+class ConfigValue;
+class Configuration;
+class MultiSectionConfiguration;
+
+/**
+ * @brief Configuration entries that were not read, see AccessTracker
+ */
+struct AccessReport
+{
+    //Task models that were loaded but whose configuration was never requested
+    std::vector<std::string> unusedTaskModels;
+    //Sections of requested task models that were never requested, by task
+    //model
+    std::map<std::string, std::vector<std::string> > unusedSections;
+    //Properties of requested sections that were never read, by task model
+    //and section. A property is only listed if its parent was read, e.g.
+    //'transform.rotation' if only 'transform.translation' was read.
+    std::map<std::string, std::map<std::string, std::vector<std::string> > > unusedProperties;
+    //Property paths of the requested sections, nested ones included
+    size_t properties;
+    size_t usedProperties;
+
+    AccessReport();
+    std::string toYaml() const;
+};
+
+/**
+ * @brief Records which task configuration properties are read
+ *
+ * While tracking is enabled, the values of every configuration returned by
+ * MultiSectionConfiguration::getConfig() (and so by
+ * TaskConfigurations::getConfig()) remember the task model, the sections
+ * and the property path they were merged from. Reading a value through
+ * SimpleConfigValue::getValue(), ComplexConfigValue::getValues() or
+ * ArrayConfigValue::getValues() marks the property and its parents as used
+ * in all these sections. Generated decoders and
+ * TypelibConfiguration::applyToValue() read through these getters. Writing
+ * a configuration as YAML does not count as a read.
+ *
+ * The report lists the task models, sections and properties that were
+ * loaded but never used, so that they can be removed from the bundles.
+ * Property paths join map keys with '.'; array elements are attributed to
+ * the array.
+ *
+ * Tracking is disabled by default, the getters then only check an atomic
+ * flag. It can be enabled programmatically or by setting the environment
+ * variable LIB_CONFIG_ACCESS_LOG to an output file, which the report is
+ * written to when the process exits. A '%p' in the file name is replaced by
+ * the process id. Only configurations requested while tracking is enabled
+ * are tracked.
+ */
+class AccessTracker
+{
+public:
+    static void setEnabled(bool enabled);
+    static bool isEnabled()
+    {
+        return enabled.load(std::memory_order_relaxed);
+    }
+    static void reset();
+    static AccessReport getReport();
+    static bool writeReport(const std::string& path);
+
+    //Hooks of the configuration model, only to be called while enabled
+    static void taskModelsLoaded(const std::vector<std::string>& taskModelNames);
+    static void configRequested(const MultiSectionConfiguration& source,
+                                const std::vector<std::string>& sections,
+                                const Configuration& result);
+    static void valueRead(const ConfigValue* value);
+    static void valueDestroyed(const ConfigValue* value);
+
+private:
+    static std::atomic<bool> enabled;
+};
+
+}
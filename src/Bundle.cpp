@@ -1,21 +1,85 @@
 #include "Bundle.hpp"
 #include <stdlib.h>
 #include <stdexcept>
+#include <algorithm>
 #include <boost/filesystem.hpp>
 #include <boost/lexical_cast.hpp>
 #include <iostream>
 #include <base/Time.hpp>
 #include <yaml-cpp/yaml.h>
 #include "YAMLConfiguration.hpp"
+#include "LoadMetrics.hpp"
+#include "LoadTrace.hpp"
+#include "ParallelFor.hpp"
+#include "DependencyResolver.hpp"
+#include "BundleRegistry.hpp"
+#include "MemoryUsage.hpp"
+#include "AccessTracker.hpp"
+#include <unordered_set>
+#include <set>
 #include <base-logging/Logging.hpp>
 
 
 namespace fs = boost::filesystem;
 using namespace libConfig;
 
-Bundle * Bundle::instance;
+std::atomic<Bundle*> Bundle::instance(nullptr);
+std::mutex Bundle::instanceMutex;
 std::vector<std::string> Bundle::_bundleSearchPaths;
 
+namespace
+{
+//Guards the lazy initialization of Bundle::_bundleSearchPaths
+std::mutex searchPathMutex;
+//Instance created by Bundle::getInstance() and its state, once the state was
+//published. Lets the threads parsing its task configurations resolve files.
+std::atomic<const Bundle*> creatingInstance(nullptr);
+std::shared_ptr<const BundleState> creatingState;
+
+//Shared by all bundles, so repeated initializations use the cached graph
+DependencyResolver& dependencyResolver()
+{
+    static DependencyResolver resolver;
+    return resolver;
+}
+
+//Lists the search paths once for all bundles
+BundleRegistry& bundleRegistry()
+{
+    static BundleRegistry registry;
+    return registry;
+}
+
+//Returns an empty string if the file is not found
+std::string tryFindFileInState(const BundleState& state, const std::string& relativePath)
+{
+    if(state.fileIndex.isBuilt()){
+        std::vector<size_t> found = state.fileIndex.find(relativePath);
+        if(found.empty()){
+            return "";
+        }
+        return (fs::path(state.activeBundles[found.front()].path) / relativePath).string();
+    }
+
+    for(const SingleBundle &bundle : state.activeBundles)
+    {
+        fs::path curPath = fs::path(bundle.path) / relativePath;
+        if(boost::filesystem::exists(curPath))
+            return curPath.string();
+    }
+    return "";
+}
+
+std::string findFileInState(const BundleState& state, const std::string& relativePath)
+{
+    std::string file = tryFindFileInState(state, relativePath);
+    if(file.empty()){
+        throw std::runtime_error("Could not find file " + relativePath);
+    }
+    return file;
+}
+}
+
 //Splits a string into a vector at the position of a specific tokens that are
 //present in the input string.
 std::vector<std::string> tokenize(std::string data, std::string delim)
@@ -48,18 +112,6 @@ std::vector<std::string> findFoldersInSearchPaths(const std::string& folderName,
     return ret;
 }
 
-std::vector<std::string> findFoldersInSearchPaths(const std::vector<std::string>& searchPaths)
-{
-    std::vector<std::string> r;
-    for(const std::string& s : searchPaths){
-        for(fs::directory_entry& p : fs::directory_iterator(s))
-            if (p.status().type() == fs::file_type::directory_file){
-                r.push_back(p.path().string());
-            }
-    }
-    return r;
-}
-
 //!
 //! @brief Checks if in one of multiple possibel search paths a given folder
 //!        exists
@@ -158,8 +210,73 @@ void SingleBundle::setAndValidatePaths()
     logBaseDir = (fs::path(path) / "logs").string();
 }
 
-Bundle::Bundle()
+Bundle::Bundle() :
+    state(std::make_shared<const BundleState>()), activeBundles(nullptr)
 {
+    activeBundleLists.emplace_back(new std::vector<SingleBundle>());
+    activeBundles.store(activeBundleLists.back().get());
+}
+
+Bundle::Bundle(const Bundle &other) :
+    state(other.getState()), activeBundles(nullptr),
+    taskConfigurations(other.taskConfigurations)
+{
+    activeBundleLists.emplace_back(new std::vector<SingleBundle>(state->activeBundles));
+    activeBundles.store(activeBundleLists.back().get());
+    std::lock_guard<std::mutex> lock(const_cast<Bundle&>(other).logMutex);
+    currentLogDir = other.currentLogDir;
+}
+
+Bundle& Bundle::operator=(const Bundle &other)
+{
+    if(this == &other){
+        return *this;
+    }
+    std::string logDir;
+    {
+        std::lock_guard<std::mutex> lock(const_cast<Bundle&>(other).logMutex);
+        logDir = other.currentLogDir;
+    }
+    std::lock_guard<std::mutex> lock(updateMutex);
+    setInitializedState(other.getState());
+    taskConfigurations = other.taskConfigurations;
+    std::lock_guard<std::mutex> logLock(logMutex);
+    currentLogDir = logDir;
+    return *this;
+}
+
+std::shared_ptr<const BundleState> Bundle::getState() const
+{
+    return std::atomic_load(&state);
+}
+
+void Bundle::setState(const std::shared_ptr<const BundleState> &next)
+{
+    std::atomic_store(&state, next);
+    if(creatingInstance.load() == this){
+        std::atomic_store(&creatingState, next);
+    }
+}
+
+void Bundle::setInitializedState(const std::shared_ptr<const BundleState> &next)
+{
+    const std::vector<SingleBundle>& current = *activeBundles.load();
+    bool changed = current.size() != next->activeBundles.size();
+    for(size_t i = 0; i < current.size() && !changed; i++){
+        const SingleBundle& a = current[i];
+        const SingleBundle& b = next->activeBundles[i];
+        changed = a.name != b.name || a.path != b.path || a.logBaseDir != b.logBaseDir ||
+                a.dataDir != b.dataDir || a.configDir != b.configDir ||
+                a.orogenConfigDir != b.orogenConfigDir;
+    }
+    if(changed){
+        activeBundleLists.emplace_back(new std::vector<SingleBundle>(next->activeBundles));
+        activeBundles.store(activeBundleLists.back().get());
+        if(activeBundleLists.size() > RETAINED_BUNDLE_LISTS + 1){
+            activeBundleLists.pop_front();
+        }
+    }
+    setState(next);
 }
 
 std::string Bundle::getSelectedBundleName()
@@ -195,23 +312,12 @@ void Bundle::unselectBundle()
 
 std::vector<SingleBundle> Bundle::getAvailableBundles()
 {
-    std::vector<SingleBundle> ret;
-    std::vector<std::string> bnames = getAvailableBundleNames();
-    for(const std::string& bname : bnames)
-    {
-        ret.push_back(SingleBundle::fromNameAndSearchPaths(bname, bundleSearchPaths()));
-    }
-    return ret;
+    return bundleRegistry().getBundles(bundleSearchPaths());
 }
 
 std::vector<std::string> Bundle::getAvailableBundleNames()
 {
-    std::vector<std::string> ret;
-    for(const std::string& bp : findFoldersInSearchPaths(bundleSearchPaths()))
-    {
-        ret.push_back(fs::path(bp).filename().string());
-    }
-    return ret;
+    return bundleRegistry().getBundleNames(bundleSearchPaths());
 }
 
 std::vector<std::string> Bundle::tokenize(std::string data, std::string delim)
@@ -229,13 +335,13 @@ std::vector<std::string> Bundle::tokenize(std::string data, std::string delim)
 
 std::string Bundle::findBundle(const std::string &bundle_name)
 {
-    SingleBundle b = SingleBundle::fromNameAndSearchPaths(bundle_name,
-                                                          bundleSearchPaths());
+    SingleBundle b = bundleRegistry().getBundle(bundle_name, bundleSearchPaths());
     return b.path;
 }
 
 std::vector<std::string> Bundle::bundleSearchPaths()
 {
+    std::lock_guard<std::mutex> lock(searchPathMutex);
     if(!_bundleSearchPaths.empty()){
         return _bundleSearchPaths;
     }
@@ -256,7 +362,7 @@ std::vector<std::string> Bundle::bundleSearchPaths()
 
 bool Bundle::initialized() const
 {
-    return activeBundles.size() > 0;
+    return getState()->activeBundles.size() > 0;
 }
 
 std::string time_to_string(timeval tv)
@@ -276,6 +382,7 @@ std::string time_to_string(timeval tv)
 
 bool Bundle::createLogDirectory()
 {
+    std::lock_guard<std::mutex> lock(logMutex);
     base::Time curTime = base::Time::now();
     fs::path logDir = fs::path(selectedBundle().logBaseDir) / time_to_string(curTime.toTimeval());
 
@@ -309,24 +416,44 @@ bool Bundle::createLogDirectory()
 
 Bundle& Bundle::getInstance()
 {
-    if(!instance){
-        instance = new Bundle();
-        bool st = instance->initialize();
+    Bundle* b = instance.load(std::memory_order_acquire);
+    if(b){
+        return *b;
+    }
+
+    std::lock_guard<std::mutex> lock(instanceMutex);
+    b = instance.load(std::memory_order_relaxed);
+    if(!b){
+        std::unique_ptr<Bundle> created(new Bundle());
+        creatingInstance.store(created.get());
+        bool st = created->initialize();
+        creatingInstance.store(nullptr);
+        std::atomic_store(&creatingState, std::shared_ptr<const BundleState>());
         if(!st){
-            instance = nullptr;
             throw(std::runtime_error(std::string()+"Error, no active bundle " +
             "configured. Please use 'rock-bundle-default'"+
             " to set one."));
         }
+        b = created.release();
+        instance.store(b, std::memory_order_release);
     }
 
-    return *instance;
+    return *b;
 }
 
 void Bundle::deleteInstance()
 {
-    delete instance;
-    instance = nullptr;
+    std::lock_guard<std::mutex> lock(instanceMutex);
+    delete instance.exchange(nullptr);
+}
+
+std::string Bundle::findInstanceFile(const std::string &relativePath)
+{
+    std::shared_ptr<const BundleState> s = std::atomic_load(&creatingState);
+    if(s){
+        return findFileInState(*s, relativePath);
+    }
+    return getInstance().findFileByName(relativePath);
 }
 
 void Bundle::loadTaskConfigurations()
@@ -339,7 +466,12 @@ void Bundle::loadTaskConfigurations()
 bool Bundle::initialize(bool loadTaskConfigs)
 {
     LOG_DEBUG_S << "Initializing Bundles";
-    activeBundles.clear();
+    LoadTrace::Span span("Bundle::initialize");
+    LoadMetrics::InitializationScope metrics;
+    std::lock_guard<std::mutex> lock(updateMutex);
+    //Built aside, readers keep using the previous state until it is published
+    std::shared_ptr<BundleState> next = std::make_shared<BundleState>();
+    std::vector<SingleBundle>& activeBundles = next->activeBundles;
     LOG_DEBUG_S << "Determining selected bundle";
     //Read environment variables:
     //  ROCK_BUNDLE: contains currently selected bundle (name or absolute path)
@@ -349,6 +481,7 @@ bool Bundle::initialize(bool loadTaskConfigs)
     if(activeBundle.empty())
     {
         LOG_ERROR_S << "ROCK_BUNDLE not set. Bundle cannot be initialized.";
+        setInitializedState(std::make_shared<const BundleState>());
         return false;
     }
 
@@ -364,10 +497,10 @@ bool Bundle::initialize(bool loadTaskConfigs)
     {
         //ROCK_BUNDLE contains bundle name
         try{
-            bundle = SingleBundle::fromNameAndSearchPaths(activeBundle,
-                                                          bundleSearchPaths());
+            bundle = bundleRegistry().getBundle(activeBundle, bundleSearchPaths());
         }catch(std::runtime_error& err){
             LOG_ERROR_S << err.what();
+            setInitializedState(std::make_shared<const BundleState>());
             return false;
         }
     }
@@ -375,6 +508,7 @@ bool Bundle::initialize(bool loadTaskConfigs)
                  bundle.path;
 
     activeBundles.push_back(bundle);
+    metrics.phaseDone(LoadMetrics::InitializationScope::SEARCH_PATH_RESOLUTION);
 
     LOG_DEBUG_S << "Discovering bundle dependencies";
     if(bundleSearchPaths().empty())
@@ -382,8 +516,9 @@ bool Bundle::initialize(bool loadTaskConfigs)
         LOG_WARN_S << "Bundle search path is not set. Dependency resolutibn " <<
                      "to other bundles is disabled.";
     }else{
-        discoverDependencies(selectedBundle(), activeBundles);
+        discoverDependencies(activeBundles.front(), activeBundles);
     }
+    metrics.phaseDone(LoadMetrics::InitializationScope::DEPENDENCY_DISCOVERY);
     LOG_INFO_S << "Active bundles: ";
     std::string active_bundles_string;
     for(SingleBundle& b : activeBundles){
@@ -391,16 +526,39 @@ bool Bundle::initialize(bool loadTaskConfigs)
     }
     LOG_INFO_S << active_bundles_string;
 
+    next->fileIndex.build(activeBundles);
+    setInitializedState(next);
+    metrics.phaseDone(LoadMetrics::InitializationScope::FILE_INDEXING);
+
     //Initialze TaskConfigurations
     if(loadTaskConfigs){
         LOG_DEBUG_S << "Loading task configuration files from bundle";
         loadTaskConfigurations();
+        metrics.phaseDone(LoadMetrics::InitializationScope::TASK_CONFIG_LOADING);
     }
     LOG_INFO_S << "Bundles successfully initialized";
+    metrics.succeeded(activeBundles.size());
 
     return true;
 }
 
+void Bundle::refreshFileIndex()
+{
+    std::lock_guard<std::mutex> lock(updateMutex);
+    std::shared_ptr<BundleState> next = std::make_shared<BundleState>();
+    next->activeBundles = getState()->activeBundles;
+    next->fileIndex.build(next->activeBundles);
+    setState(next);
+}
+
+void Bundle::refreshFileIndex(const std::string &relativePath)
+{
+    std::lock_guard<std::mutex> lock(updateMutex);
+    std::shared_ptr<BundleState> next = std::make_shared<BundleState>(*getState());
+    next->fileIndex.refreshPath(relativePath);
+    setState(next);
+}
+
 const std::string &Bundle::getActiveBundleName()
 {
 	return selectedBundle().name;
@@ -408,7 +566,7 @@ const std::string &Bundle::getActiveBundleName()
 
 const std::vector<SingleBundle>& Bundle::getActiveBundles()
 {
-	return activeBundles;
+	return *activeBundles.load();
 }
 
 const std::vector<std::string> Bundle::getActiveBundleNames()
@@ -423,7 +581,7 @@ const std::vector<std::string> Bundle::getActiveBundleNames()
 
 SingleBundle& Bundle::selectedBundle()
 {
-    return activeBundles.front();
+    return activeBundles.load()->front();
 }
 
 const std::string &Bundle::getConfigurationDirectory()
@@ -434,12 +592,11 @@ const std::string &Bundle::getConfigurationDirectory()
 std::string Bundle::getConfigurationPath(const std::string &task)
 {
     std::string relativePath = "config/orogen/"+ task + ".yml";
-    try{
-        std::string result = findFileByName(relativePath);
-        return result;
-    } catch (std::runtime_error &e){
+    std::string result = tryFindFileByName(relativePath);
+    if(result.empty()){
         throw std::runtime_error("Bundle::getConfigurationPath : Error, could not find config path for task " + task);
     }
+    return result;
 }
 
 const bool Bundle::hasConfigForTask(const std::string &taskModelName) const
@@ -449,9 +606,14 @@ const bool Bundle::hasConfigForTask(const std::string &taskModelName) const
 
 std::string Bundle::getLogDirectory()
 {
-    if(currentLogDir.empty()){
-        createLogDirectory();
+    {
+        std::lock_guard<std::mutex> lock(logMutex);
+        if(!currentLogDir.empty()){
+            return currentLogDir;
+        }
     }
+    createLogDirectory();
+    std::lock_guard<std::mutex> lock(logMutex);
     return currentLogDir;
 }
 
@@ -462,19 +624,26 @@ const std::string& Bundle::getDataDirectory()
 
 std::string Bundle::findFileByName(const std::string& relativePath)
 {
-    for(const SingleBundle &bundle : activeBundles)
-    {
-        fs::path curPath = fs::path(bundle.path) / relativePath;
-        if(boost::filesystem::exists(curPath))
-            return curPath.string();
-    }
-    throw std::runtime_error("Could not find file " + relativePath);
+    return findFileInState(*getState(), relativePath);
+}
+
+std::string Bundle::tryFindFileByName(const std::string& relativePath)
+{
+    return tryFindFileInState(*getState(), relativePath);
 }
 
 std::vector<std::string> Bundle::findFilesByName(const std::string& relativePath)
 {
+    std::shared_ptr<const BundleState> s = getState();
     std::vector<std::string> paths;
-    for(const SingleBundle &bundle : activeBundles)
+    if(s->fileIndex.isBuilt()){
+        for(size_t idx : s->fileIndex.find(relativePath)){
+            paths.push_back((fs::path(s->activeBundles[idx].path) / relativePath).string());
+        }
+        return paths;
+    }
+
+    for(const SingleBundle &bundle : s->activeBundles)
     {
         fs::path curPath = fs::path(bundle.path) / relativePath;
         if(boost::filesystem::exists(curPath))
@@ -486,8 +655,14 @@ std::vector<std::string> Bundle::findFilesByName(const std::string& relativePath
 std::vector<std::string> Bundle::findFilesByExtension(
         const std::string &relativePath, const std::string &ext)
 {
+    LoadTrace::Span span("Bundle::findFilesByExtension", relativePath);
+    std::shared_ptr<const BundleState> s = getState();
+    if(s->fileIndex.isBuilt()){
+        return s->fileIndex.findByExtension(relativePath, ext);
+    }
+
     std::vector<std::string> ret;
-    for(const SingleBundle &bundle : activeBundles)
+    for(const SingleBundle &bundle : s->activeBundles)
     {
         fs::path root = fs::path(bundle.path) / relativePath;
         if(!fs::exists(root) || !fs::is_directory(root))
@@ -524,15 +699,7 @@ std::vector<std::string> Bundle::getConfigurationPathsForTaskModel(
 void Bundle::discoverDependencies(const SingleBundle &bundle,
                                   std::vector<SingleBundle> &dependencies)
 {
-    fs::path config_file = bundle.configDir / fs::path("bundle.yml");
-    if(!fs::exists(config_file)){
-        // No bundle.yml file exists.
-        // We assume that this bundle has no depending bundles
-        LOG_INFO_S << "Bundle '" + bundle.name + "' does not contain a bundle" <<
-                     " configuration file '."<<config_file;
-        return;
-    }
-
+    LoadTrace::Span span("Bundle::discoverDependencies", bundle.name);
     //The vector dependencies encodes the priority bundles are search for.
     //i.e. first element in vector is the first to look for a certain file.
     //We want to have a breadth-first discovery behaviour. This means we first
@@ -544,26 +711,17 @@ void Bundle::discoverDependencies(const SingleBundle &bundle,
     //   |- bundle_3
     // is resolved to this priorization:
     //  [bundle_1, bundle_2, bundle_3, bundle_4]
-    std::vector<std::string> deps = loadDependenciesFromYAML(config_file.string());
-    std::vector<SingleBundle> to_inspect;
-    for(const std::string& bundleName : deps){
-        // Don't consider duplicates and avoid cyclic dependencies.
-        // TODO: When we do it this way, cyclic dependencies are ignored.
-        //       Better throw here?
-        std::vector<SingleBundle>::iterator it = std::find(dependencies.begin(),
-                                                           dependencies.end(),
-                                                           bundleName);
-        if(it != dependencies.end()){
-            continue;
-        }
-        SingleBundle d = SingleBundle::fromNameAndSearchPaths(bundleName,
-                                                              bundleSearchPaths());
-        dependencies.push_back(d);
-        to_inspect.push_back(d);
-    }
+    std::shared_ptr<const BundleDependencyGraph> graph =
+            dependencyResolver().resolve(bundle, bundleSearchPaths());
 
-    for(const SingleBundle& bundle : to_inspect){
-        discoverDependencies(bundle, dependencies);
+    std::unordered_set<std::string> known;
+    for(const SingleBundle& d : dependencies){
+        known.insert(d.name);
+    }
+    for(size_t i = 1; i < graph->bundles.size(); i++){
+        if(known.insert(graph->bundles[i].name).second){
+            dependencies.push_back(graph->bundles[i]);
+        }
     }
 }
 
@@ -598,47 +756,298 @@ std::vector<std::string> Bundle::loadDependenciesFromYAML(const std::string &con
 }
 
 
-TaskConfigurations::TaskConfigurations()
+TaskConfigurations::TaskConfigurations() :
+    taskConfigurations(std::make_shared<const TaskConfigurationMap>()),
+    loaderThreads(0), lazyLoading(false)
 {
+    const char* lazy = getenv("LIB_CONFIG_LAZY_LOADING");
+    lazyLoading = lazy && std::string(lazy) == "1";
+}
 
+TaskConfigurations::TaskConfigurations(const TaskConfigurations &other) :
+    loaderThreads(other.loaderThreads), lazyLoading(other.lazyLoading)
+{
+    std::lock_guard<std::mutex> lock(other.mutex);
+    taskConfigurations = other.getSnapshot();
+    pendingFiles = other.pendingFiles;
 }
 
-void TaskConfigurations::initialize(const std::vector<std::string> &configFiles)
+TaskConfigurations& TaskConfigurations::operator=(const TaskConfigurations &other)
+{
+    if(this == &other){
+        return *this;
+    }
+    std::shared_ptr<const TaskConfigurationMap> copy;
+    std::map<std::string, std::vector<std::string> > pendingCopy;
+    {
+        std::lock_guard<std::mutex> lock(other.mutex);
+        copy = other.getSnapshot();
+        pendingCopy = other.pendingFiles;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    replaceSnapshot(copy);
+    pendingFiles.swap(pendingCopy);
+    loaderThreads = other.loaderThreads;
+    lazyLoading = other.lazyLoading;
+    return *this;
+}
+
+void TaskConfigurations::setLoaderThreads(unsigned threads)
 {
-    taskConfigurations.clear();
+    loaderThreads = threads;
+}
+
+void TaskConfigurations::setLazyLoading(bool lazy)
+{
+    lazyLoading = lazy;
+}
+
+bool TaskConfigurations::isLazyLoading() const
+{
+    return lazyLoading;
+}
+
+void TaskConfigurations::loadConfigFiles(const std::vector<std::string> &configFiles,
+        std::map<std::string, MultiSectionConfiguration> &target) const
+{
+    //Every file is parsed into its own slot
+    std::vector<MultiSectionConfiguration> parsed(configFiles.size());
+    std::vector<char> loaded(configFiles.size(), false);
+    std::vector<std::exception_ptr> errors(configFiles.size());
+    parallelFor(configFiles.size(), loaderThreads, [&](size_t i){
+        LOG_DEBUG_S << "Loading config file " << configFiles[i];
+        try{
+            loaded[i] = parsed[i].loadFromBundle(configFiles[i]);
+        }catch(...){
+            errors[i] = std::current_exception();
+        }
+    });
 
-    for(const std::string& cfgFilePath : configFiles)
+    //The files of a task model are merged in the given order, as the serial
+    //loop did. Task models are independent of each other.
+    std::map<std::string, std::vector<size_t> > filesByTask;
+    for(size_t i = 0; i < configFiles.size(); i++)
     {
-        MultiSectionConfiguration cfgFile;
-        LOG_DEBUG_S << "Loading config file " << cfgFilePath;
-        bool st = cfgFile.loadFromBundle(cfgFilePath);
-        if(!st){
-            LOG_WARN_S << "File " << cfgFilePath << " could not be parsed";
+        if(errors[i]){
+            std::rethrow_exception(errors[i]);
+        }
+        if(!loaded[i]){
+            LOG_WARN_S << "File " << configFiles[i] << " could not be parsed";
             continue;
         }
-        std::string& task = cfgFile.taskModelName;
-        if(taskConfigurations.find(task) == taskConfigurations.end()){
-            //First config file for that task
-            taskConfigurations.insert(std::make_pair(task, cfgFile));
-        }else
+        filesByTask[parsed[i].taskModelName].push_back(i);
+    }
+
+    std::vector<const std::vector<size_t>*> tasks;
+    for(const auto& it : filesByTask){
+        tasks.push_back(&it.second);
+    }
+    std::vector<std::exception_ptr> mergeErrors(tasks.size());
+    parallelFor(tasks.size(), loaderThreads, [&](size_t t){
+        const std::vector<size_t>& files = *tasks[t];
+        //Due to ordering in vector the later files are of lower priority
+        try{
+            for(size_t k = 1; k < files.size(); k++){
+                parsed[files[0]].mergeConfigFile(parsed[files[k]]);
+            }
+        }catch(...){
+            mergeErrors[t] = std::current_exception();
+        }
+    });
+    //Rethrown in task model order, as the serial merge would have
+    for(const std::exception_ptr& error : mergeErrors){
+        if(error){
+            std::rethrow_exception(error);
+        }
+    }
+
+    for(const auto& it : filesByTask)
+    {
+        MultiSectionConfiguration& cfgFile = parsed[it.second.front()];
+        std::map<std::string, MultiSectionConfiguration>::iterator existing =
+                target.find(it.first);
+        if(existing == target.end()){
+            target.emplace(it.first, std::move(cfgFile));
+        }else{
+            existing->second.mergeConfigFile(cfgFile);
+        }
+    }
+}
+
+void TaskConfigurations::initialize(const std::vector<std::string> &configFiles)
+{
+    LoadTrace::Span span("TaskConfigurations::initialize");
+    std::map<std::string, MultiSectionConfiguration> loaded;
+    std::map<std::string, std::vector<std::string> > pending;
+    std::shared_ptr<TaskConfigurationMap> configs = std::make_shared<TaskConfigurationMap>();
+    if(lazyLoading){
+        for(const std::string& cfgFilePath : configFiles)
+        {
+            //Same naming rule as MultiSectionConfiguration::loadFromBundle
+            std::string task = fs::path(cfgFilePath).stem().string();
+            if(task.find("::") == std::string::npos){
+                LOG_WARN_S << "File " << cfgFilePath << " could not be parsed";
+                continue;
+            }
+            pending[task].push_back(cfgFilePath);
+        }
+    }else{
+        loadConfigFiles(configFiles, loaded);
+    }
+
+    if(AccessTracker::isEnabled()){
+        std::vector<std::string> taskModelNames;
+        for(const auto& it : loaded){
+            taskModelNames.push_back(it.first);
+        }
+        for(const auto& it : pending){
+            taskModelNames.push_back(it.first);
+        }
+        AccessTracker::taskModelsLoaded(taskModelNames);
+    }
+    for(auto& it : loaded){
+        configs->emplace(it.first, std::make_shared<const MultiSectionConfiguration>(
+                             std::move(it.second)));
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    replaceSnapshot(configs);
+    pendingFiles.swap(pending);
+}
+
+void TaskConfigurations::replaceSnapshot(const std::shared_ptr<const TaskConfigurationMap> &next)
+{
+    //Readers may still use the configurations of the current map
+    retired.push_back(getSnapshot());
+    if(retired.size() > RETAINED_SNAPSHOTS){
+        retired.pop_front();
+    }
+    std::atomic_store(&taskConfigurations, next);
+}
+
+std::shared_ptr<const MultiSectionConfiguration> TaskConfigurations::findConfig(
+        const std::string &taskModelName, std::unique_lock<std::mutex> &lock) const
+{
+    while(true)
+    {
+        std::shared_ptr<const TaskConfigurationMap> configs = getSnapshot();
+        TaskConfigurationMap::const_iterator it = configs->find(taskModelName);
+        if(it != configs->end()){
+            return it->second;
+        }
+        std::map<std::string, std::vector<std::string> >::const_iterator pending =
+                pendingFiles.find(taskModelName);
+        if(pending == pendingFiles.end()){
+            return nullptr;
+        }
+
+        //Parse without holding the lock, so other task models stay accessible
+        std::vector<std::string> files = pending->second;
+        std::map<std::string, MultiSectionConfiguration> loaded;
+        lock.unlock();
         {
-            //There was already a config file laoded. Due to ordering in vector
-            //the new config file must be of lower priority
-            taskConfigurations.at(task).mergeConfigFile(cfgFile);
+            LoadTrace::Span span("TaskConfigurations::loadTask", taskModelName);
+            try{
+                loadConfigFiles(files, loaded);
+            }catch(...){
+                lock.lock();
+                throw;
+            }
+        }
+        lock.lock();
+
+        //Another thread may have loaded or reloaded the task in the meantime
+        pending = pendingFiles.find(taskModelName);
+        if(pending != pendingFiles.end() && pending->second == files)
+        {
+            pendingFiles.erase(pending);
+            std::map<std::string, MultiSectionConfiguration>::iterator l =
+                    loaded.find(taskModelName);
+            if(l != loaded.end()){
+                std::shared_ptr<TaskConfigurationMap> next =
+                        std::make_shared<TaskConfigurationMap>(*getSnapshot());
+                next->emplace(taskModelName, std::make_shared<const MultiSectionConfiguration>(
+                                  std::move(l->second)));
+                std::atomic_store(&taskConfigurations,
+                                  std::shared_ptr<const TaskConfigurationMap>(next));
+            }
         }
     }
 }
 
+bool TaskConfigurations::reloadTask(const std::string &taskModelName,
+                                    const std::vector<std::string> &configFiles)
+{
+    if(lazyLoading){
+        std::lock_guard<std::mutex> lock(mutex);
+        if(getSnapshot()->count(taskModelName) == 0){
+            //Not loaded yet, only the file list changes
+            if(configFiles.empty()){
+                pendingFiles.erase(taskModelName);
+            }else{
+                pendingFiles[taskModelName] = configFiles;
+            }
+            return true;
+        }
+    }
+
+    //Parse without holding the lock, readers are only blocked for the swap
+    std::map<std::string, MultiSectionConfiguration> loaded;
+    try{
+        loadConfigFiles(configFiles, loaded);
+    }catch(std::runtime_error& err){
+        LOG_ERROR_S << "Could not reload configuration of task " <<
+                       taskModelName << ": " << err.what();
+        return false;
+    }
+
+    std::shared_ptr<const MultiSectionConfiguration> config;
+    std::map<std::string, MultiSectionConfiguration>::iterator it =
+            loaded.find(taskModelName);
+    if(it != loaded.end()){
+        config = std::make_shared<const MultiSectionConfiguration>(std::move(it->second));
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    pendingFiles.erase(taskModelName);
+    std::shared_ptr<TaskConfigurationMap> next =
+            std::make_shared<TaskConfigurationMap>(*getSnapshot());
+    TaskConfigurationMap::iterator existing = next->find(taskModelName);
+    if(existing != next->end()){
+        next->erase(existing);
+    }
+    if(config){
+        next->emplace(taskModelName, config);
+    }
+    replaceSnapshot(next);
+    return true;
+}
+
 Configuration TaskConfigurations::getConfig(const std::string &taskModelName,
                                             const std::vector<std::string> &sections) const
 {
-    return getMultiConfig( taskModelName ).getConfig( sections );
+    //Merged without holding the lock, the configuration is not modified
+    return getMultiConfigPtr(taskModelName)->getConfig( sections );
 }
 
 const MultiSectionConfiguration &TaskConfigurations::getMultiConfig(const std::string &taskModelName) const
 {
-    if(hasConfigForTask(taskModelName)){
-        return taskConfigurations.at(taskModelName);
+    return *getMultiConfigPtr(taskModelName);
+}
+
+std::shared_ptr<const MultiSectionConfiguration> TaskConfigurations::getMultiConfigPtr(
+        const std::string &taskModelName) const
+{
+    //Loaded task models are looked up without locking
+    std::shared_ptr<const TaskConfigurationMap> configs = getSnapshot();
+    TaskConfigurationMap::const_iterator it = configs->find(taskModelName);
+    if(it != configs->end()){
+        return it->second;
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    std::shared_ptr<const MultiSectionConfiguration> config = findConfig(taskModelName, lock);
+    if(config){
+        return config;
     }
     else{
         throw std::out_of_range("No task configuration for task model name " + taskModelName + " found.");
@@ -647,5 +1056,57 @@ const MultiSectionConfiguration &TaskConfigurations::getMultiConfig(const std::s
 
 const bool TaskConfigurations::hasConfigForTask(const std::string &taskModelName) const
 {
-    return taskConfigurations.find( taskModelName ) != taskConfigurations.end();
+    if(getSnapshot()->count( taskModelName ) > 0){
+        return true;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    return getSnapshot()->count( taskModelName ) > 0 ||
+            pendingFiles.find( taskModelName ) != pendingFiles.end();
+}
+
+std::vector<std::string> TaskConfigurations::getTaskModelNames() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<std::string> ret;
+    for(const auto& it : *getSnapshot()){
+        ret.push_back(it.first);
+    }
+    for(const auto& it : pendingFiles){
+        ret.push_back(it.first);
+    }
+    std::sort(ret.begin(), ret.end());
+    return ret;
+}
+
+std::shared_ptr<const TaskConfigurationMap> TaskConfigurations::getSnapshot() const
+{
+    return std::atomic_load(&taskConfigurations);
+}
+
+size_t TaskConfigurations::memoryUsage() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::shared_ptr<const TaskConfigurationMap> configs = getSnapshot();
+    size_t bytes = sizeof(*this) + mapNodesMemoryUsage(pendingFiles);
+    //Retired maps share most of their configurations with the current one
+    std::set<const TaskConfigurationMap*> maps;
+    std::set<const MultiSectionConfiguration*> counted;
+    std::vector<std::shared_ptr<const TaskConfigurationMap> > all(retired.begin(), retired.end());
+    all.push_back(configs);
+    for(const auto& map : all)
+    {
+        if(!maps.insert(map.get()).second){
+            continue;
+        }
+        bytes += sizeof(TaskConfigurationMap) + CONTROL_BLOCK_SIZE + mapNodesMemoryUsage(*map);
+        for(const auto& it : *map){
+            if(counted.insert(it.second.get()).second){
+                bytes += it.second->memoryUsage() + CONTROL_BLOCK_SIZE;
+            }
+        }
+    }
+    for(const auto& it : pendingFiles){
+        bytes += stringsMemoryUsage(it.second);
+    }
+    return bytes;
 }
@@ -3,7 +3,12 @@
 
 #include <string>
 #include <vector>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <deque>
 #include "Configuration.hpp"
+#include "BundleFileIndex.hpp"
 #include <boost/tokenizer.hpp>
 
 namespace libConfig
@@ -41,36 +46,173 @@ public:
     };
 };
 
+//Merged configurations by task model name
+typedef std::map<std::string, std::shared_ptr<const MultiSectionConfiguration> > TaskConfigurationMap;
+
 class TaskConfigurations{
 private:
     //Contains the merged configuration files from all bundles. The key-string
-    //is the task model name
-    std::map<std::string, MultiSectionConfiguration> taskConfigurations;
+    //is the task model name. Filled on first access in lazy loading mode.
+    //A published map is never modified, changes publish a modified copy.
+    //Only accessed through std::atomic_load and std::atomic_store, so
+    //readers of loaded task models do not lock.
+    mutable std::shared_ptr<const TaskConfigurationMap> taskConfigurations;
+    //Maps replaced by reloadTask(), initialize() and assignments, the most
+    //recent last. Keep the configurations referenced by getMultiConfig()
+    //alive for RETAINED_SNAPSHOTS further replacements.
+    std::deque<std::shared_ptr<const TaskConfigurationMap> > retired;
+    //Files of the task models that were not loaded yet, with decreasing
+    //priority. Only used in lazy loading mode.
+    mutable std::map<std::string, std::vector<std::string> > pendingFiles;
+    //Serializes the changes of taskConfigurations (see BundleWatcher) and
+    //guards pendingFiles and retired
+    mutable std::mutex mutex;
+    unsigned loaderThreads;
+    bool lazyLoading;
+
+    void loadConfigFiles(const std::vector<std::string>& configFiles,
+            std::map<std::string, MultiSectionConfiguration>& target) const;
+    //Returns nullptr if there is no configuration for the task model. Has to
+    //be called with the mutex locked, loads pending files in lazy mode.
+    //Publishes next and retires the current map, has to be called with the
+    //mutex locked
+    void replaceSnapshot(const std::shared_ptr<const TaskConfigurationMap>& next);
+    std::shared_ptr<const MultiSectionConfiguration> findConfig(
+            const std::string& taskModelName, std::unique_lock<std::mutex>& lock) const;
 public:
+    static const size_t RETAINED_SNAPSHOTS = 8;
+
     TaskConfigurations();
+    TaskConfigurations(const TaskConfigurations& other);
+    TaskConfigurations& operator=(const TaskConfigurations& other);
+
+    /**
+     * @brief Loads the given configuration files
+     * The files have to be given with decreasing priority. They are parsed
+     * concurrently, then the files of each task model are merged in the
+     * given order, so the result is the same for any number of threads.
+     * If loading files throws, the error of the first of them in the given
+     * order is rethrown.
+     */
     void initialize(const std::vector<std::string>& configFiles);
+    //Number of threads parsing files in initialize(), 0 uses one per core
+    void setLoaderThreads(unsigned threads);
+
+    /**
+     * @brief In lazy loading mode initialize() only records which files
+     * exist for each task model, using the task::Model.yml naming. The files
+     * of a task model are parsed and merged on the first getConfig() or
+     * getMultiConfig() for it, which then throws parse errors.
+     * Enabled by default if the environment variable LIB_CONFIG_LAZY_LOADING
+     * is set to 1. Takes effect on the next initialize().
+     */
+    void setLazyLoading(bool lazy);
+    bool isLazyLoading() const;
+
+    /**
+     * @brief Re-parses the configuration files of a single task model and
+     * replaces its merged configuration
+     * The files have to be given with decreasing priority, as in
+     * initialize(). If no file is given, the task model is removed. On
+     * parse errors the previous configuration is kept.
+     * The previous configuration is not modified but replaced, so readers
+     * on other threads keep a consistent view of it.
+     * @return false if one of the files could not be loaded
+     */
+    bool reloadTask(const std::string& taskModelName,
+                    const std::vector<std::string>& configFiles);
+
     Configuration getConfig (const std::string& taskModelName,
                             const std::vector<std::string>& sections) const;
+    /**
+     * @brief Returns the merged configuration files of a task model
+     * If the configurations are replaced in the meantime, e.g. by a
+     * reload, the reference refers to the previous configuration. It stays
+     * valid for RETAINED_SNAPSHOTS replacements. Use getMultiConfigPtr() to
+     * keep a configuration longer.
+     */
     const MultiSectionConfiguration& getMultiConfig(const std::string& taskModelName) const;
+    //Like getMultiConfig(), but keeps the configuration alive as long as the
+    //pointer is held
+    std::shared_ptr<const MultiSectionConfiguration> getMultiConfigPtr(
+            const std::string& taskModelName) const;
     const bool hasConfigForTask(const std::string& taskModelName) const;
+    std::vector<std::string> getTaskModelNames() const;
+
+    /**
+     * @brief Returns the loaded configurations
+     * The map is not modified while it is held, reloads and initialize()
+     * publish a new one. In lazy loading mode task models that were not
+     * accessed yet are missing.
+     */
+    std::shared_ptr<const TaskConfigurationMap> getSnapshot() const;
+
+    /**
+     * @brief Approximate heap bytes of the loaded configurations, see
+     * ConfigValue::memoryUsage()
+     * In lazy loading mode only task models that were accessed are included,
+     * pending ones only with their file names.
+     */
+    size_t memoryUsage() const;
+};
+
+/**
+ * @brief Resolved state of a Bundle
+ * A state is never modified once it was published. initialize() and the
+ * index refreshes build a new state and swap it in atomically, so readers
+ * always see a consistent pair of active bundles and file index.
+ */
+struct BundleState
+{
+    //Contains the hierarchy of the selected bundles and its dependencies
+    std::vector<SingleBundle> activeBundles;
+    //Answers the file queries without probing the filesystem
+    BundleFileIndex fileIndex;
 };
 
 // Represents a bundle with all its bundles it depends on
 class Bundle
 {
 private:
-    static Bundle *instance;
+    static std::atomic<Bundle*> instance;
+    //Serializes the creation of the singleton
+    static std::mutex instanceMutex;
     static std::vector<std::string> _bundleSearchPaths;
-    
 
-    //Contains the hierarchy of the selected bundles and its dependencies
-    std::vector<SingleBundle> activeBundles;
+    //Only accessed through std::atomic_load and std::atomic_store
+    std::shared_ptr<const BundleState> state;
+    //Active bundles of the current state for the accessors that return
+    //references. The last RETAINED_BUNDLE_LISTS lists that were replaced by
+    //initialize() are kept in activeBundleLists, so that these references
+    //stay valid when another thread re-initializes the bundle, e.g. a
+    //BundleWatcher. A new list is only added if the active bundles changed.
+    std::atomic<std::vector<SingleBundle>*> activeBundles;
+    std::deque<std::unique_ptr<std::vector<SingleBundle> > > activeBundleLists;
+    //Serializes initialize() and the index refreshes, readers do not lock
+    std::mutex updateMutex;
     std::string currentLogDir;
+    std::mutex logMutex;
+
+    void setState(const std::shared_ptr<const BundleState>& next);
+    //Publishes the state of initialize(), has to be called with updateMutex
+    //locked
+    void setInitializedState(const std::shared_ptr<const BundleState>& next);
 
 public:
+    static const size_t RETAINED_BUNDLE_LISTS = 8;
+
     Bundle();
+    Bundle(const Bundle& other);
+    Bundle& operator=(const Bundle& other);
     TaskConfigurations taskConfigurations;
 
+    /**
+     * @brief Returns the current state of the bundle
+     * The state stays valid and unchanged while it is held, even if the
+     * bundle is re-initialized by another thread in the meantime.
+     */
+    std::shared_ptr<const BundleState> getState() const;
+
     static std::string getSelectedBundleName();
     static bool isBundleSelected();
     static bool setSelectedBundle(const std::string& bundle_name);
@@ -101,16 +243,28 @@ public:
 
     /**
      * @brief Creates singelton class instance
+     * Thread-safe. Threads calling this while the instance is created wait
+     * until it is initialized.
      * @return
      */
     static Bundle &getInstance();
 
     /**
      * @brief Delete the singleton class
+     * Must not be called while other threads use the instance.
      * @return
      */
     static void deleteInstance();
 
+    /**
+     * @brief Checks in the active bundles of the singleton instance for the
+     * relative file path and returns the first match
+     * Unlike getInstance().findFileByName() this also works while the
+     * instance loads its task configurations, i.e. from the threads parsing
+     * them.
+     */
+    static std::string findInstanceFile(const std::string& relativePath);
+
     /**
      * @brief Loads task configuration files from the selected bundles into
      * memory
@@ -134,6 +288,21 @@ public:
      */
     bool initialize(bool loadTaskConfigs=true);
 
+    /**
+     * @brief Re-reads the file index of the active bundles
+     * The index is built by initialize(). It has to be refreshed when files
+     * are added to or removed from the bundles later on, otherwise
+     * findFileByName() and the related queries do not see the change.
+     */
+    void refreshFileIndex();
+    //Refreshes a single path relative to the bundle roots, e.g. a file that
+    //was just created
+    void refreshFileIndex(const std::string& relativePath);
+
+    //The references returned by the following functions stay valid until
+    //the active bundles changed RETAINED_BUNDLE_LISTS more times, e.g. by
+    //re-initializations of a BundleWatcher. Use getState() to keep them
+    //longer.
     const std::string &getActiveBundleName();
     const std::vector<SingleBundle>& getActiveBundles();
     const std::vector<std::string> getActiveBundleNames();
@@ -198,6 +367,14 @@ public:
      */
     std::string findFileByName(const std::string &relativePath);
 
+    /**
+     * Like findFileByName(), but returns an empty string instead of
+     * throwing if the file does not exist. Use it for optional files:
+     * misses are answered from the file index, or from the cache of
+     * failed probes for the parts of the bundles that are not indexed.
+     */
+    std::string tryFindFileByName(const std::string &relativePath);
+
     /**
      * Checks in all active bundles for the relative file path
      * and returns all matches.
@@ -208,14 +385,17 @@ public:
             const std::string& relativePath, const std::string& ext);
 
     /**
-     * Find all dependencies of the given bundle. Ignores cyclic dependencies.
+     * Find all dependencies of the given bundle and append those that are
+     * not in dependencies yet. Cyclic dependencies are reported as warnings
+     * and ignored. The resolved dependencies are cached, see
+     * DependencyResolver.
      */
     void discoverDependencies(const SingleBundle &bundle, std::vector<SingleBundle> &dependencies);
 
     /**
      * Load the dependencies from the given bundle config file
      */
-    std::vector<std::string> loadDependenciesFromYAML(const std::string &config_file);
+    static std::vector<std::string> loadDependenciesFromYAML(const std::string &config_file);
 };
 
 }//end of namespace
@@ -0,0 +1,479 @@
+#include "BundleFileIndex.hpp"
+#include "Bundle.hpp"
+#include "LoadTrace.hpp"
+#include "DirectoryScanner.hpp"
+#include "FileStamp.hpp"
+#include <boost/filesystem.hpp>
+#include <algorithm>
+#include <mutex>
+#include <chrono>
+
+namespace fs = boost::filesystem;
+using namespace libConfig;
+
+namespace
+{
+const uint32_t ROOT = 0;
+const uint32_t NONE = uint32_t(-1);
+//Only the configuration is indexed. Data and log directories can be large
+//and change while the bundle is in use.
+const char* INDEXED_DIRECTORY = "config";
+//Not descended within the configuration directories
+const std::vector<std::string> VCS_DIRECTORIES = {".git", ".svn", ".hg", ".bzr"};
+//Failed probes are only cached if the directory was not modified within
+//this time, in nanoseconds
+const int64_t RECENT_MODIFICATION = 2000000000;
+
+//Appends the files with the extension in the order a depth-first walk with
+//recursive_directory_iterator visits them. Linked directories are not
+//descended, as by that walk.
+void appendFiles(const ScannedDirectory& dir, const fs::path& path,
+                 const std::string& ext, std::vector<std::string>& result)
+{
+    for(const ScannedEntry& entry : dir.entries)
+    {
+        fs::path entryPath = path / entry.name;
+        if(entry.kind == ScannedEntry::FILE){
+            if(entryPath.extension() == ext){
+                result.push_back(entryPath.string());
+            }
+        }else if(entry.kind == ScannedEntry::DIRECTORY && entry.content){
+            appendFiles(*entry.content, entryPath, ext, result);
+        }
+    }
+}
+
+//Reproduces Bundle::findFilesByExtension for parts of the bundles that are
+//not indexed. The roots are scanned concurrently, the files are appended in
+//the order of the roots. Empty roots are skipped.
+void walkDirectories(const std::vector<std::string>& roots, const std::string& ext,
+                     std::vector<std::string>& result)
+{
+    std::vector<std::string> scanned;
+    for(const std::string& root : roots){
+        if(!root.empty()){
+            scanned.push_back(root);
+        }
+    }
+    if(scanned.empty()){
+        return;
+    }
+    DirectoryScanner scanner;
+    std::vector<std::unique_ptr<ScannedDirectory> > trees = scanner.scan(scanned);
+    for(size_t i = 0; i < scanned.size(); i++){
+        appendFiles(*trees[i], scanned[i], ext, result);
+    }
+}
+}
+
+//Bounded, it is cleared when full
+struct BundleFileIndex::MissCache
+{
+    static const size_t MAX_SIZE = 4096;
+    std::mutex mutex;
+    //Full path that did not exist and the stamp of its deepest existing
+    //directory at that time
+    std::unordered_map<std::string, FileStamp> entries;
+};
+
+BundleFileIndex::BundleFileIndex() :
+    misses(new MissCache())
+{
+}
+
+BundleFileIndex::~BundleFileIndex()
+{
+}
+
+BundleFileIndex::BundleFileIndex(const BundleFileIndex &other) :
+    misses(new MissCache())
+{
+    std::shared_lock<std::shared_mutex> lock(other.mutex);
+    bundlePaths = other.bundlePaths;
+    nodes = other.nodes;
+    children = other.children;
+}
+
+BundleFileIndex& BundleFileIndex::operator=(const BundleFileIndex &other)
+{
+    if(this != &other){
+        BundleFileIndex copy(other);
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        bundlePaths.swap(copy.bundlePaths);
+        nodes.swap(copy.nodes);
+        children.swap(copy.children);
+    }
+    return *this;
+}
+
+void BundleFileIndex::build(const std::vector<SingleBundle> &bundles, unsigned threads)
+{
+    LoadTrace::Span span("BundleFileIndex::build");
+    //The new index is built without holding the lock, queries are answered
+    //from the old one in the meantime
+    BundleFileIndex next;
+    next.nodes.push_back(Node());
+    next.nodes[ROOT].parent = NONE;
+    uint32_t config = next.addChild(ROOT, INDEXED_DIRECTORY);
+    std::vector<std::string> roots;
+    for(uint32_t b = 0; b < bundles.size(); b++)
+    {
+        next.bundlePaths.push_back(bundles[b].path);
+        roots.push_back((fs::path(bundles[b].path) / INDEXED_DIRECTORY).string());
+    }
+
+    DirectoryScanner scanner(threads);
+    std::vector<std::unique_ptr<ScannedDirectory> > trees =
+            scanner.scan(roots, VCS_DIRECTORIES);
+    //Merging in bundle order gives the same tree as a serial scan
+    for(uint32_t b = 0; b < bundles.size(); b++)
+    {
+        if(!fs::is_directory(bundles[b].path)){
+            continue;
+        }
+        next.nodes[ROOT].bundles.push_back(b);
+        boost::system::error_code ec;
+        fs::file_status linkStatus = fs::symlink_status(roots[b], ec);
+        if(fs::is_symlink(linkStatus)){
+            next.probe(config, b, roots[b]);
+        }else if(fs::is_directory(linkStatus)){
+            next.nodes[config].bundles.push_back(b);
+            next.merge(config, b, *trees[b]);
+        }else if(fs::is_regular_file(linkStatus)){
+            next.nodes[config].bundles.push_back(b);
+            next.nodes[config].files.push_back(b);
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    bundlePaths.swap(next.bundlePaths);
+    nodes.swap(next.nodes);
+    children.swap(next.children);
+}
+
+void BundleFileIndex::clear()
+{
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    bundlePaths.clear();
+    nodes.clear();
+    children.clear();
+}
+
+bool BundleFileIndex::isBuilt() const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return !nodes.empty();
+}
+
+size_t BundleFileIndex::size() const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return nodes.size();
+}
+
+uint32_t BundleFileIndex::addChild(uint32_t parent, const std::string &name)
+{
+    ChildKey key = {parent, name};
+    std::unordered_map<ChildKey, uint32_t, ChildKeyHash>::const_iterator it =
+            children.find(key);
+    if(it != children.end()){
+        return it->second;
+    }
+    uint32_t id = nodes.size();
+    nodes.push_back(Node());
+    nodes[id].parent = parent;
+    nodes[id].name = name;
+    nodes[parent].children.push_back(id);
+    children.emplace(std::move(key), id);
+    return id;
+}
+
+void BundleFileIndex::merge(uint32_t node, uint32_t bundle, const ScannedDirectory &directory)
+{
+    for(const ScannedEntry& entry : directory.entries)
+    {
+        uint32_t child = addChild(node, entry.name);
+        insertSorted(nodes[child].bundles, bundle);
+        switch(entry.kind)
+        {
+            case ScannedEntry::FILE:
+                insertSorted(nodes[child].files, bundle);
+                break;
+            case ScannedEntry::LINKED_DIRECTORY:
+                //Not followed, to avoid cycles
+                insertSorted(nodes[child].unindexed, bundle);
+                insertSorted(nodes[child].links, bundle);
+                break;
+            case ScannedEntry::DIRECTORY:
+                if(entry.content){
+                    merge(child, bundle, *entry.content);
+                }else{
+                    //Skipped by the scanner
+                    insertSorted(nodes[child].unindexed, bundle);
+                }
+                break;
+            case ScannedEntry::OTHER:
+                break;
+        }
+    }
+}
+
+void BundleFileIndex::probe(uint32_t node, uint32_t bundle, const std::string &path)
+{
+    eraseValue(nodes[node].bundles, bundle);
+    eraseValue(nodes[node].files, bundle);
+    eraseValue(nodes[node].unindexed, bundle);
+    eraseValue(nodes[node].links, bundle);
+
+    boost::system::error_code ec;
+    fs::file_status linkStatus = fs::symlink_status(path, ec);
+    fs::file_status status = fs::is_symlink(linkStatus) ? fs::status(path, ec) : linkStatus;
+    if(!fs::exists(status)){
+        return;
+    }
+    insertSorted(nodes[node].bundles, bundle);
+    if(fs::is_regular_file(status)){
+        insertSorted(nodes[node].files, bundle);
+    }else if(fs::is_directory(status)){
+        if(fs::is_symlink(linkStatus)){
+            //Not followed, to avoid cycles
+            insertSorted(nodes[node].unindexed, bundle);
+            insertSorted(nodes[node].links, bundle);
+        }else if(std::find(VCS_DIRECTORIES.begin(), VCS_DIRECTORIES.end(),
+                           nodes[node].name) != VCS_DIRECTORIES.end())
+        {
+            insertSorted(nodes[node].unindexed, bundle);
+        }else{
+            //Called for single changed paths, threads would only add overhead
+            DirectoryScanner scanner(1);
+            merge(node, bundle, *scanner.scan({path}, VCS_DIRECTORIES)[0]);
+        }
+    }
+}
+
+void BundleFileIndex::refreshPath(const std::string &relativePath)
+{
+    std::vector<std::string> components;
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    if(nodes.empty() || !isIndexed(relativePath, components)){
+        return;
+    }
+
+    for(uint32_t b = 0; b < bundlePaths.size(); b++)
+    {
+        if(!contains(nodes[ROOT].bundles, b)){
+            continue;
+        }
+        uint32_t node = ROOT;
+        bool indexed = true;
+        for(size_t i = 0; i + 1 < components.size() && indexed; i++)
+        {
+            node = addChild(node, components[i]);
+            indexed = !contains(nodes[node].unindexed, b);
+        }
+        if(!indexed){
+            //Answered from the filesystem anyway
+            continue;
+        }
+
+        node = addChild(node, components.back());
+        probe(node, b, (fs::path(bundlePaths[b]) / relativePath).string());
+        //A new file implies its parent directories
+        if(contains(nodes[node].bundles, b)){
+            for(uint32_t n = nodes[node].parent; n != NONE; n = nodes[n].parent){
+                insertSorted(nodes[n].bundles, b);
+            }
+        }
+    }
+}
+
+std::vector<size_t> BundleFileIndex::find(const std::string &relativePath) const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    std::vector<bool> found(bundlePaths.size(), false);
+    std::vector<std::string> components;
+    if(!isIndexed(relativePath, components)){
+        for(size_t b = 0; b < bundlePaths.size(); b++){
+            found[b] = exists((fs::path(bundlePaths[b]) / relativePath).string());
+        }
+    }else{
+        uint32_t node = ROOT;
+        for(size_t i = 0; i <= components.size() && node != NONE; i++)
+        {
+            for(uint32_t b : nodes[node].unindexed){
+                found[b] = exists((fs::path(bundlePaths[b]) / relativePath).string());
+            }
+            if(i == components.size()){
+                for(uint32_t b : nodes[node].bundles){
+                    found[b] = true;
+                }
+                break;
+            }
+            std::unordered_map<ChildKey, uint32_t, ChildKeyHash>::const_iterator it =
+                    children.find(ChildKey{node, components[i]});
+            node = it == children.end() ? NONE : it->second;
+        }
+    }
+
+    std::vector<size_t> ret;
+    for(size_t b = 0; b < found.size(); b++){
+        if(found[b]){
+            ret.push_back(b);
+        }
+    }
+    return ret;
+}
+
+void BundleFileIndex::collect(uint32_t node, uint32_t bundle, const std::string &path,
+                              const std::string &ext, std::vector<std::string> &result) const
+{
+    for(uint32_t child : nodes[node].children)
+    {
+        const Node& c = nodes[child];
+        if(!contains(c.bundles, bundle) && !contains(c.unindexed, bundle)){
+            continue;
+        }
+        std::string childPath = (fs::path(path) / c.name).string();
+        if(contains(c.files, bundle)){
+            if(fs::path(c.name).extension() == ext){
+                result.push_back(childPath);
+            }
+        }else if(contains(c.links, bundle)){
+            //recursive_directory_iterator does not follow symlinks
+        }else if(contains(c.unindexed, bundle)){
+            walkDirectories({childPath}, ext, result);
+        }else{
+            collect(child, bundle, childPath, ext, result);
+        }
+    }
+}
+
+std::vector<std::string> BundleFileIndex::findByExtension(const std::string &relativePath,
+                                                          const std::string &ext) const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    std::vector<std::string> ret;
+    std::vector<std::string> components;
+    bool indexed = isIndexed(relativePath, components);
+    //Consecutive bundles that are not indexed are scanned together
+    std::vector<std::string> walkRoots;
+    for(uint32_t b = 0; b < bundlePaths.size(); b++)
+    {
+        std::string root = (fs::path(bundlePaths[b]) / relativePath).string();
+        uint32_t node = indexed ? ROOT : NONE;
+        bool walk = !indexed;
+        for(size_t i = 0; i < components.size() && node != NONE && !walk; i++)
+        {
+            std::unordered_map<ChildKey, uint32_t, ChildKeyHash>::const_iterator it =
+                    children.find(ChildKey{node, components[i]});
+            node = it == children.end() ? NONE : it->second;
+            walk = node != NONE && contains(nodes[node].unindexed, b);
+        }
+
+        if(walk){
+            walkRoots.push_back(root);
+        }else if(node != NONE && contains(nodes[node].bundles, b) &&
+                 !contains(nodes[node].files, b))
+        {
+            walkDirectories(walkRoots, ext, ret);
+            walkRoots.clear();
+            collect(node, b, root, ext, ret);
+        }
+    }
+    walkDirectories(walkRoots, ext, ret);
+    return ret;
+}
+
+bool BundleFileIndex::splitPath(const std::string &relativePath,
+                                std::vector<std::string> &components)
+{
+    fs::path path(relativePath);
+    if(path.has_root_path()){
+        return false;
+    }
+    for(const fs::path& element : path)
+    {
+        std::string name = element.string();
+        if(name == ".."){
+            return false;
+        }
+        if(!name.empty() && name != "." && name != "/"){
+            components.push_back(name);
+        }
+    }
+    return true;
+}
+
+bool BundleFileIndex::isIndexed(const std::string &relativePath,
+                                std::vector<std::string> &components)
+{
+    //Paths leaving the bundle are not indexed either
+    return splitPath(relativePath, components) && !components.empty() &&
+            components[0] == INDEXED_DIRECTORY;
+}
+
+void BundleFileIndex::insertSorted(std::vector<uint32_t> &list, uint32_t value)
+{
+    std::vector<uint32_t>::iterator it = std::lower_bound(list.begin(), list.end(), value);
+    if(it == list.end() || *it != value){
+        list.insert(it, value);
+    }
+}
+
+void BundleFileIndex::eraseValue(std::vector<uint32_t> &list, uint32_t value)
+{
+    std::vector<uint32_t>::iterator it = std::lower_bound(list.begin(), list.end(), value);
+    if(it != list.end() && *it == value){
+        list.erase(it);
+    }
+}
+
+bool BundleFileIndex::contains(const std::vector<uint32_t> &list, uint32_t value)
+{
+    return std::binary_search(list.begin(), list.end(), value);
+}
+
+bool BundleFileIndex::exists(const std::string &path) const
+{
+    {
+        std::lock_guard<std::mutex> lock(misses->mutex);
+        std::unordered_map<std::string, FileStamp>::const_iterator it =
+                misses->entries.find(path);
+        if(it != misses->entries.end())
+        {
+            if(it->second.isCurrent()){
+                return false;
+            }
+            misses->entries.erase(it);
+        }
+    }
+    if(fs::exists(path)){
+        return true;
+    }
+
+    //Creating the path or any missing directory on the way modifies the
+    //deepest existing directory. The path is checked again after the stamp
+    //was taken, so it cannot be created unnoticed in between.
+    fs::path dir = fs::path(path).parent_path();
+    while(!dir.empty() && !fs::exists(dir)){
+        dir = dir.parent_path();
+    }
+    FileStamp stamp(dir.string());
+    if(fs::exists(path)){
+        return true;
+    }
+    //Timestamps are coarse, a directory modified within the last moments
+    //could be modified again without changing its mtime
+    const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+    if(!stamp.exists || now - stamp.mtime < RECENT_MODIFICATION){
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(misses->mutex);
+    if(misses->entries.size() >= MissCache::MAX_SIZE){
+        misses->entries.clear();
+    }
+    misses->entries[path] = stamp;
+    return false;
+}
@@ -0,0 +1,138 @@
+#ifndef BUNDLE_FILE_INDEX_H
+#define BUNDLE_FILE_INDEX_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <shared_mutex>
+#include <memory>
+#include <cstdint>
+
+namespace libConfig
+{
+
+class SingleBundle;
+struct ScannedDirectory;
+
+/**
+ * @brief In-memory index of the files of the active bundles
+ *
+ * The relative paths of all bundles are stored once in a shared tree of
+ * path components, so common prefixes like config/orogen are stored only
+ * once. Each node knows in which bundles it exists. Lookups hash one path
+ * component after the other and do not touch the filesystem, which matters
+ * for bundles on network filesystems.
+ *
+ * Only the config directories of the bundles are indexed, as they hold
+ * the files that are looked up repeatedly. Version control directories
+ * and symlinked directories below them are not indexed. Lookups of all
+ * other paths fall back to probing the filesystem, so the results are the
+ * same as without the index. Probes that found nothing are cached and
+ * answered again as long as the deepest existing directory of the probed
+ * path was not modified.
+ *
+ * All methods are thread-safe.
+ */
+class BundleFileIndex
+{
+public:
+    BundleFileIndex();
+    BundleFileIndex(const BundleFileIndex& other);
+    BundleFileIndex& operator=(const BundleFileIndex& other);
+    ~BundleFileIndex();
+
+    /**
+     * @brief Indexes the config directories of the given bundles, which
+     * have to be given in priority order. The bundles and their
+     * subdirectories are scanned concurrently.
+     * @param threads: Number of scanning threads, 0 uses one per core
+     */
+    void build(const std::vector<SingleBundle>& bundles, unsigned threads = 0);
+    void clear();
+    bool isBuilt() const;
+
+    /**
+     * @brief Re-probes a single relative path in all bundles and updates
+     * the index accordingly, e.g. after a file was created or removed
+     */
+    void refreshPath(const std::string& relativePath);
+
+    /**
+     * @brief Returns the indices of the bundles containing the relative
+     * path, a file or a directory, in priority order
+     */
+    std::vector<size_t> find(const std::string& relativePath) const;
+
+    /**
+     * @brief Returns the full paths of all regular files with the given
+     * extension below the relative directory, grouped by bundle in priority
+     * order. Symlinked directories are not descended, as with
+     * boost::filesystem::recursive_directory_iterator.
+     */
+    std::vector<std::string> findByExtension(const std::string& relativePath,
+                                             const std::string& ext) const;
+
+    //Number of indexed path components
+    size_t size() const;
+
+private:
+    struct Node
+    {
+        uint32_t parent;
+        std::string name;
+        std::vector<uint32_t> children;
+        //Bundles in which the path exists, in ascending order
+        std::vector<uint32_t> bundles;
+        //Bundles in which the path is a regular file
+        std::vector<uint32_t> files;
+        //Bundles in which the content of the path is not indexed and the
+        //filesystem has to be asked
+        std::vector<uint32_t> unindexed;
+        //Bundles in which the path is a symlink to a directory
+        std::vector<uint32_t> links;
+    };
+
+    struct ChildKey
+    {
+        uint32_t parent;
+        std::string name;
+        bool operator==(const ChildKey& other) const
+        {
+            return parent == other.parent && name == other.name;
+        }
+    };
+
+    struct ChildKeyHash
+    {
+        size_t operator()(const ChildKey& key) const
+        {
+            return std::hash<std::string>()(key.name) ^ (size_t(key.parent) * 0x9e3779b97f4a7c15ULL);
+        }
+    };
+
+    struct MissCache;
+
+    mutable std::shared_mutex mutex;
+    //Has its own lock, it is updated by the const lookups
+    std::unique_ptr<MissCache> misses;
+    std::vector<std::string> bundlePaths;
+    std::vector<Node> nodes;
+    std::unordered_map<ChildKey, uint32_t, ChildKeyHash> children;
+
+    uint32_t addChild(uint32_t parent, const std::string& name);
+    void merge(uint32_t node, uint32_t bundle, const ScannedDirectory& directory);
+    void probe(uint32_t node, uint32_t bundle, const std::string& path);
+    bool exists(const std::string& path) const;
+    void collect(uint32_t node, uint32_t bundle, const std::string& path,
+                 const std::string& ext, std::vector<std::string>& result) const;
+    static bool splitPath(const std::string& relativePath, std::vector<std::string>& components);
+    //Splits the path and checks whether it is below a config directory
+    static bool isIndexed(const std::string& relativePath, std::vector<std::string>& components);
+    static void insertSorted(std::vector<uint32_t>& list, uint32_t value);
+    static void eraseValue(std::vector<uint32_t>& list, uint32_t value);
+    static bool contains(const std::vector<uint32_t>& list, uint32_t value);
+};
+
+}
+
+#endif // BUNDLE_FILE_INDEX_H
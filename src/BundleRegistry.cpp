@@ -0,0 +1,127 @@
+#include "BundleRegistry.hpp"
+#include "FileStamp.hpp"
+#include "LoadTrace.hpp"
+#include <boost/filesystem.hpp>
+#include <unordered_set>
+
+namespace fs = boost::filesystem;
+using namespace libConfig;
+
+struct BundleRegistry::SearchPath
+{
+    FileStamp stamp;
+    //Directories in the order returned by the filesystem
+    std::vector<std::string> names;
+    std::unordered_set<std::string> nameSet;
+};
+
+struct BundleRegistry::BundleRecord
+{
+    SingleBundle bundle;
+    //setAndValidatePaths() depends on the content of these directories
+    FileStamp root;
+    FileStamp config;
+};
+
+BundleRegistry::BundleRegistry() :
+    scanCount(0)
+{
+}
+
+const BundleRegistry::SearchPath& BundleRegistry::listSearchPath(const std::string &path)
+{
+    std::shared_ptr<SearchPath>& entry = searchPaths[path];
+    if(entry && entry->stamp.isCurrent()){
+        return *entry;
+    }
+
+    LoadTrace::Span span("BundleRegistry::listSearchPath", path);
+    //The stamp is taken first, so changes made while listing are detected
+    //on the next call
+    std::shared_ptr<SearchPath> listed = std::make_shared<SearchPath>();
+    listed->stamp = FileStamp(path);
+    //Search paths that do not exist or are no directories are listed as
+    //empty, the stamp picks them up once they are created
+    boost::system::error_code ec;
+    for(fs::directory_iterator it(path, ec), end; !ec && it != end; it.increment(ec))
+    {
+        if (it->status().type() == fs::file_type::directory_file){
+            std::string name = it->path().filename().string();
+            listed->names.push_back(name);
+            listed->nameSet.insert(name);
+        }
+    }
+    scanCount++;
+    entry = listed;
+    return *entry;
+}
+
+const SingleBundle& BundleRegistry::bundleRecord(const std::string &name,
+                                                 const std::string &path)
+{
+    std::shared_ptr<BundleRecord>& record = bundles[path];
+    if(record && record->root.isCurrent() && record->config.isCurrent()){
+        return record->bundle;
+    }
+
+    std::shared_ptr<BundleRecord> next = std::make_shared<BundleRecord>();
+    next->root = FileStamp(path);
+    next->config = FileStamp((fs::path(path) / "config").string());
+    next->bundle.name = name;
+    next->bundle.path = path;
+    next->bundle.setAndValidatePaths();
+    record = next;
+    return record->bundle;
+}
+
+std::vector<std::string> BundleRegistry::getBundleNames(
+        const std::vector<std::string> &searchPaths)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<std::string> ret;
+    for(const std::string& path : searchPaths)
+    {
+        const SearchPath& sp = listSearchPath(path);
+        ret.insert(ret.end(), sp.names.begin(), sp.names.end());
+    }
+    return ret;
+}
+
+std::vector<SingleBundle> BundleRegistry::getBundles(
+        const std::vector<std::string> &searchPaths)
+{
+    std::vector<SingleBundle> ret;
+    for(const std::string& name : getBundleNames(searchPaths)){
+        ret.push_back(getBundle(name, searchPaths));
+    }
+    return ret;
+}
+
+SingleBundle BundleRegistry::getBundle(const std::string &name,
+                                       const std::vector<std::string> &searchPaths)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for(const std::string& path : searchPaths)
+        {
+            const SearchPath& sp = listSearchPath(path);
+            if(sp.nameSet.count(name)){
+                return bundleRecord(name, (fs::path(path) / name).string());
+            }
+        }
+    }
+    return SingleBundle::fromNameAndSearchPaths(name, searchPaths);
+}
+
+void BundleRegistry::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    searchPaths.clear();
+    bundles.clear();
+}
+
+size_t BundleRegistry::getScanCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return scanCount;
+}
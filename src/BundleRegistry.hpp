@@ -0,0 +1,73 @@
+#ifndef BUNDLE_REGISTRY_H
+#define BUNDLE_REGISTRY_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include "Bundle.hpp"
+
+namespace libConfig
+{
+
+/**
+ * @brief In-memory registry of the bundles in the bundle search paths
+ *
+ * Each search path is listed once and the SingleBundle records of its
+ * bundles are kept. A search path is listed again when its modification
+ * time changed, i.e. when a bundle was added, removed or renamed. A bundle
+ * record is rebuilt when the bundle directory or its config directory was
+ * modified. Checking this takes one stat per search path and two per bundle
+ * record that is returned.
+ *
+ * All methods are thread-safe.
+ */
+class BundleRegistry
+{
+public:
+    BundleRegistry();
+
+    /**
+     * @brief Returns the names of all directories in the search paths, in
+     * the order of the search paths. A name is listed once per search path
+     * that contains it.
+     */
+    std::vector<std::string> getBundleNames(const std::vector<std::string>& searchPaths);
+
+    /**
+     * @brief Returns the bundle for each name returned by getBundleNames(),
+     * taken from the first search path that contains it
+     */
+    std::vector<SingleBundle> getBundles(const std::vector<std::string>& searchPaths);
+
+    /**
+     * @brief Returns the bundle with the given name from the first search
+     * path that contains it
+     * Names that are not a directory in the search paths, e.g. relative
+     * paths, are resolved like SingleBundle::fromNameAndSearchPaths(),
+     * which throws std::runtime_error if the bundle cannot be found.
+     */
+    SingleBundle getBundle(const std::string& name,
+                           const std::vector<std::string>& searchPaths);
+
+    void clear();
+    //Number of search path listings, for testing the cache
+    size_t getScanCount() const;
+
+private:
+    struct SearchPath;
+    struct BundleRecord;
+
+    mutable std::mutex mutex;
+    std::map<std::string, std::shared_ptr<SearchPath> > searchPaths;
+    std::map<std::string, std::shared_ptr<BundleRecord> > bundles;
+    size_t scanCount;
+
+    const SearchPath& listSearchPath(const std::string& path);
+    const SingleBundle& bundleRecord(const std::string& name, const std::string& path);
+};
+
+}
+
+#endif // BUNDLE_REGISTRY_H
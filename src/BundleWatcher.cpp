@@ -0,0 +1,302 @@
+#include "BundleWatcher.hpp"
+#include "Bundle.hpp"
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#include <algorithm>
+#include <boost/filesystem.hpp>
+#include <base-logging/Logging.hpp>
+
+namespace fs = boost::filesystem;
+using namespace libConfig;
+
+static const uint32_t WATCH_MASK = IN_CLOSE_WRITE | IN_MOVED_TO |
+        IN_MOVED_FROM | IN_DELETE | IN_CREATE;
+
+BundleWatcher::BundleWatcher(Bundle &bundle, unsigned int coalesceMs) :
+    bundle(bundle), coalesceMs(coalesceMs), inotifyFd(-1), running(false),
+    nextCallbackId(0)
+{
+    stopPipe[0] = -1;
+    stopPipe[1] = -1;
+}
+
+BundleWatcher::~BundleWatcher()
+{
+    stop();
+}
+
+bool BundleWatcher::start()
+{
+    if(running){
+        return true;
+    }
+    if(!bundle.initialized()){
+        LOG_ERROR_S << "Cannot watch a bundle that is not initialized";
+        return false;
+    }
+
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(inotifyFd < 0){
+        LOG_ERROR_S << "Could not initialize inotify: " << strerror(errno);
+        return false;
+    }
+    if(pipe2(stopPipe, O_CLOEXEC) != 0){
+        LOG_ERROR_S << "Could not create pipe: " << strerror(errno);
+        close(inotifyFd);
+        inotifyFd = -1;
+        return false;
+    }
+
+    addWatches();
+    running = true;
+    thread = std::thread(&BundleWatcher::run, this);
+    return true;
+}
+
+void BundleWatcher::stop()
+{
+    if(!running){
+        return;
+    }
+    char c = 0;
+    if(write(stopPipe[1], &c, 1) != 1){
+        LOG_ERROR_S << "Could not signal watcher thread to stop";
+    }
+    thread.join();
+    running = false;
+
+    removeWatches();
+    close(inotifyFd);
+    close(stopPipe[0]);
+    close(stopPipe[1]);
+    inotifyFd = -1;
+    stopPipe[0] = -1;
+    stopPipe[1] = -1;
+}
+
+bool BundleWatcher::isRunning() const
+{
+    return running;
+}
+
+int BundleWatcher::subscribe(const Callback &callback)
+{
+    std::lock_guard<std::mutex> lock(callbackMutex);
+    int id = nextCallbackId++;
+    callbacks.insert(std::make_pair(id, callback));
+    return id;
+}
+
+void BundleWatcher::unsubscribe(int id)
+{
+    std::lock_guard<std::mutex> lock(callbackMutex);
+    callbacks.erase(id);
+}
+
+void BundleWatcher::addWatch(const std::string &dir)
+{
+    int wd = inotify_add_watch(inotifyFd, dir.c_str(), WATCH_MASK);
+    if(wd < 0){
+        LOG_WARN_S << "Could not watch directory " << dir << ": " <<
+                      strerror(errno);
+        return;
+    }
+    watches[wd] = dir;
+}
+
+void BundleWatcher::addWatches()
+{
+    for(const SingleBundle& sb : bundle.getActiveBundles())
+    {
+        //The config directory is watched for changes of bundle.yml and for
+        //creation of the orogen directory
+        if(!sb.configDir.empty()){
+            addWatch(sb.configDir);
+        }
+        if(sb.orogenConfigDir.empty()){
+            continue;
+        }
+
+        //Task configurations are searched recursively, so subdirectories
+        //are watched as well
+        orogenDirs.push_back(sb.orogenConfigDir);
+        addWatch(sb.orogenConfigDir);
+        //Directories may vanish or be unreadable while they are listed
+        boost::system::error_code ec;
+        fs::recursive_directory_iterator it(sb.orogenConfigDir, ec);
+        fs::recursive_directory_iterator endit;
+        for(; !ec && it != endit; it.increment(ec))
+        {
+            boost::system::error_code statError;
+            if(fs::is_directory(it->path(), statError)){
+                orogenDirs.push_back(it->path().string());
+                addWatch(it->path().string());
+            }
+        }
+        if(ec){
+            LOG_WARN_S << "Could not watch all directories in " <<
+                          sb.orogenConfigDir << ": " << ec.message();
+        }
+    }
+}
+
+void BundleWatcher::removeWatches()
+{
+    for(const std::pair<const int, std::string>& w : watches){
+        inotify_rm_watch(inotifyFd, w.first);
+    }
+    watches.clear();
+    orogenDirs.clear();
+}
+
+void BundleWatcher::run()
+{
+    struct pollfd fds[2];
+    fds[0].fd = inotifyFd;
+    fds[0].events = POLLIN;
+    fds[1].fd = stopPipe[0];
+    fds[1].events = POLLIN;
+
+    alignas(struct inotify_event) char buffer[4096];
+
+    while(true)
+    {
+        std::set<std::string> changedTasks;
+        bool bundleChanged = false;
+
+        //Block until the first event, then collect events until there was
+        //no event for coalesceMs
+        int timeout = -1;
+        while(true)
+        {
+            int st = poll(fds, 2, timeout);
+            if(st < 0 && errno == EINTR){
+                continue;
+            }
+            if(st < 0){
+                LOG_ERROR_S << "Polling inotify failed: " << strerror(errno);
+                return;
+            }
+            if(fds[1].revents & POLLIN){
+                return;
+            }
+            if(st == 0){
+                break;
+            }
+
+            ssize_t len;
+            while((len = read(inotifyFd, buffer, sizeof(buffer))) > 0)
+            {
+                for(char* ptr = buffer; ptr < buffer + len;
+                    ptr += sizeof(struct inotify_event) + ((struct inotify_event*)ptr)->len)
+                {
+                    const struct inotify_event* ev = (const struct inotify_event*)ptr;
+                    if(ev->mask & IN_Q_OVERFLOW){
+                        bundleChanged = true;
+                        continue;
+                    }
+                    std::map<int, std::string>::const_iterator w = watches.find(ev->wd);
+                    if(w == watches.end() || ev->len == 0){
+                        continue;
+                    }
+                    std::string name = ev->name;
+                    bool isOrogenDir = std::find(orogenDirs.begin(), orogenDirs.end(),
+                                                 w->second) != orogenDirs.end();
+
+                    if(ev->mask & IN_ISDIR){
+                        //A directory containing task configurations appeared
+                        //or vanished
+                        if(isOrogenDir || name == "orogen"){
+                            bundleChanged = true;
+                        }
+                    }else if(!isOrogenDir && name == "bundle.yml"){
+                        bundleChanged = true;
+                    }else if(isOrogenDir && !(ev->mask & IN_CREATE) &&
+                             fs::path(name).extension() == ".yml"){
+                        //Creation is followed by IN_CLOSE_WRITE
+                        changedTasks.insert(fs::path(name).stem().string());
+                    }
+                }
+            }
+            timeout = coalesceMs;
+        }
+
+        if(bundleChanged){
+            reloadAll();
+        }else if(!changedTasks.empty()){
+            reloadTasks(changedTasks);
+        }
+    }
+}
+
+void BundleWatcher::reloadTasks(const std::set<std::string> &taskModels)
+{
+    std::vector<std::string> reloaded;
+    for(const std::string& task : taskModels)
+    {
+        //Only task models following the oroGen naming are loaded
+        if(task.find("::") == std::string::npos){
+            continue;
+        }
+        bundle.refreshFileIndex((fs::path("config") / "orogen" / (task + ".yml")).string());
+        std::vector<std::string> files;
+        for(const std::string& dir : orogenDirs)
+        {
+            fs::path candidate = fs::path(dir) / (task + ".yml");
+            if(fs::is_regular_file(candidate)){
+                files.push_back(candidate.string());
+            }
+        }
+        LOG_INFO_S << "Reloading configuration of task " << task;
+        if(bundle.taskConfigurations.reloadTask(task, files)){
+            reloaded.push_back(task);
+        }
+    }
+    if(!reloaded.empty()){
+        notify(reloaded);
+    }
+}
+
+void BundleWatcher::reloadAll()
+{
+    LOG_INFO_S << "Bundle configuration changed, reinitializing bundle";
+    std::vector<std::string> previous = bundle.taskConfigurations.getTaskModelNames();
+    //Initialized aside, so that the bundle and the watches are kept if the
+    //changed files cannot be loaded, e.g. while bundle.yml is half written.
+    //The next change triggers another attempt.
+    Bundle next;
+    next.taskConfigurations.setLazyLoading(bundle.taskConfigurations.isLazyLoading());
+    try{
+        if(!next.initialize(true)){
+            LOG_ERROR_S << "Reinitializing bundle failed";
+            return;
+        }
+    }catch(std::exception& e){
+        LOG_ERROR_S << "Reinitializing bundle failed: " << e.what();
+        return;
+    }catch(...){
+        LOG_ERROR_S << "Reinitializing bundle failed with an unknown error";
+        return;
+    }
+    bundle = next;
+    removeWatches();
+    addWatches();
+
+    std::set<std::string> changed(previous.begin(), previous.end());
+    for(const std::string& task : bundle.taskConfigurations.getTaskModelNames()){
+        changed.insert(task);
+    }
+    notify(std::vector<std::string>(changed.begin(), changed.end()));
+}
+
+void BundleWatcher::notify(const std::vector<std::string> &taskModels)
+{
+    std::lock_guard<std::mutex> lock(callbackMutex);
+    for(const std::pair<const int, Callback>& cb : callbacks){
+        cb.second(taskModels);
+    }
+}
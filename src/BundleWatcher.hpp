@@ -0,0 +1,93 @@
+#ifndef BUNDLE_WATCHER_H
+#define BUNDLE_WATCHER_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <functional>
+
+namespace libConfig
+{
+
+class Bundle;
+
+/**
+ * @brief Watches the task configuration files of all active bundles and
+ * reloads them in the background when they change.
+ *
+ * The watcher subscribes with inotify to the config/orogen directory (and
+ * its subdirectories) and the config directory of every active bundle of
+ * the given Bundle. Bursts of events are coalesced, then only the
+ * MultiSectionConfiguration entries of the affected task models are
+ * re-parsed. A change of a config/bundle.yml file changes the set of active
+ * bundles, so in that case the whole Bundle is initialized again. If that
+ * fails, the previous state of the Bundle is kept.
+ *
+ * Reloads are applied from the watcher thread. Subscribers are called from
+ * the same thread after the new configurations are in place.
+ */
+class BundleWatcher
+{
+public:
+    //Receives the names of the task models whose configuration changed
+    typedef std::function<void (const std::vector<std::string>&)> Callback;
+
+    /**
+     * @param bundle: Initialized bundle whose task configurations are kept
+     * up to date. Must outlive the watcher.
+     * @param coalesceMs: Time without further events after which a burst
+     * of events is considered complete
+     */
+    BundleWatcher(Bundle& bundle, unsigned int coalesceMs = 100);
+    ~BundleWatcher();
+
+    /**
+     * @brief Installs the watches and starts the background thread
+     * @return false if the bundle is not initialized or inotify is not
+     * available
+     */
+    bool start();
+    void stop();
+    bool isRunning() const;
+
+    /**
+     * @brief Registers a callback for changed task models
+     * @return id that can be passed to unsubscribe()
+     */
+    int subscribe(const Callback& callback);
+    void unsubscribe(int id);
+
+private:
+    Bundle& bundle;
+    unsigned int coalesceMs;
+    int inotifyFd;
+    int stopPipe[2];
+    std::thread thread;
+    std::atomic<bool> running;
+
+    //Maps inotify watch descriptors to the watched directories
+    std::map<int, std::string> watches;
+    //config/orogen directories (including subdirectories) in bundle
+    //priority order
+    std::vector<std::string> orogenDirs;
+
+    std::mutex callbackMutex;
+    std::map<int, Callback> callbacks;
+    int nextCallbackId;
+
+    void addWatches();
+    void removeWatches();
+    void addWatch(const std::string& dir);
+    void run();
+    void reloadTasks(const std::set<std::string>& taskModels);
+    void reloadAll();
+    void notify(const std::vector<std::string>& taskModels);
+};
+
+}//end of namespace
+
+#endif // BUNDLE_WATCHER_H
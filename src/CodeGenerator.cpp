@@ -0,0 +1,185 @@
+#include "CodeGenerator.hpp"
+#include <typelib/registry.hh>
+#include <typelib/typemodel.hh>
+#include <sstream>
+#include <map>
+#include <stdexcept>
+
+using namespace libConfig;
+
+namespace
+{
+
+void generateEnum(const Typelib::Enum& type, std::ostream& out)
+{
+    const std::string cxxName = " ::" + CodeGenerator::cxxTypeName(type.getName());
+    out << "template <>\n"
+        << "struct ConfigDecoder<" << cxxName << ">\n"
+        << "{\n"
+        << "    static void decode(const ConfigValue& config," << cxxName << "& out,\n"
+        << "                       const ConfigPath* path)\n"
+        << "    {\n"
+        << "        const std::string& s = getConfigScalar(config, \"" << type.getName() << "\", path);\n"
+        << "        //Symbols may be written as Ruby symbols, i.e. ':VALUE'\n"
+        << "        const char* symbol = s.c_str() + (!s.empty() && s[0] == ':');\n";
+    for(const auto& value : type.values())
+    {
+        out << "        if(strcmp(symbol, \"" << value.first << "\") == 0){\n"
+            << "            out = static_cast<" << cxxName << ">(" << value.second << ");\n"
+            << "            return;\n"
+            << "        }\n";
+    }
+    out << "        throwConfigError(path, \"'\" + s + \"' is not a symbol of enum "
+        << type.getName() << "\");\n"
+        << "    }\n"
+        << "};\n\n";
+}
+
+void generateCompound(const Typelib::Compound& type, std::ostream& out)
+{
+    const std::string cxxName = " ::" + CodeGenerator::cxxTypeName(type.getName());
+
+    //Fields grouped by name length, so most names are compared at most once
+    std::map<size_t, std::vector<std::string> > fieldsBySize;
+    for(const Typelib::Field& field : type.getFields()){
+        fieldsBySize[field.getName().size()].push_back(field.getName());
+    }
+
+    out << "template <>\n"
+        << "struct ConfigDecoder<" << cxxName << ">\n"
+        << "{\n"
+        << "    static void decodeField(const std::string& name, const ConfigValue& config,\n"
+        << "                           " << cxxName << "& out, const ConfigPath* path)\n"
+        << "    {\n"
+        << "        ConfigPath fieldPath = {path, &name, 0};\n";
+    if(!fieldsBySize.empty())
+    {
+        out << "        switch(name.size())\n"
+            << "        {\n";
+        for(const auto& size : fieldsBySize)
+        {
+            out << "            case " << size.first << ":\n";
+            for(const std::string& field : size.second)
+            {
+                out << "                if(name == \"" << field << "\"){\n"
+                    << "                    decodeConfigValue(config, out." << field << ", &fieldPath);\n"
+                    << "                    return;\n"
+                    << "                }\n";
+            }
+            out << "                break;\n";
+        }
+        out << "        }\n";
+    }
+    out << "        throwConfigError(&fieldPath, \"type " << type.getName() << " has no such field\");\n"
+        << "    }\n"
+        << "\n"
+        << "    static void decode(const ConfigValue& config," << cxxName << "& out,\n"
+        << "                       const ConfigPath* path)\n"
+        << "    {\n"
+        << "        for(const auto& it : getConfigMap(config, \"" << type.getName() << "\", path).getValues()){\n"
+        << "            decodeField(it.first, *it.second, out, path);\n"
+        << "        }\n"
+        << "    }\n"
+        << "};\n\n";
+}
+}
+
+CodeGenerator::CodeGenerator(const Typelib::Registry &registry) :
+    registry(registry)
+{
+}
+
+void CodeGenerator::addInclude(const std::string &header)
+{
+    includes.push_back(header);
+}
+
+void CodeGenerator::addType(const std::string &typeName)
+{
+    const Typelib::Type* type = registry.get(typeName);
+    if(!type){
+        throw std::runtime_error("Type " + typeName + " is not in the registry");
+    }
+    collect(*type);
+}
+
+void CodeGenerator::collect(const Typelib::Type &type)
+{
+    if(!visited.insert(&type).second){
+        return;
+    }
+
+    switch(type.getCategory())
+    {
+        case Typelib::Type::Numeric:
+            //Decoded by the templates in ConfigDecoder.hpp
+            break;
+        case Typelib::Type::Enum:
+            types.push_back(&type);
+            break;
+        case Typelib::Type::Compound:
+            for(const Typelib::Field& field : static_cast<const Typelib::Compound&>(type).getFields()){
+                collect(field.getType());
+            }
+            types.push_back(&type);
+            break;
+        case Typelib::Type::Array:
+            collect(static_cast<const Typelib::Array&>(type).getIndirection());
+            break;
+        case Typelib::Type::Container:
+        {
+            const Typelib::Container& cont = static_cast<const Typelib::Container&>(type);
+            if(cont.kind() == "/std/vector"){
+                collect(cont.getIndirection());
+            }else if(cont.kind() != "/std/string"){
+                throw std::runtime_error("Container " + type.getName() + " is not supported");
+            }
+            break;
+        }
+        default:
+            throw std::runtime_error("Type " + type.getName() + " is not supported");
+    }
+}
+
+std::string CodeGenerator::generate() const
+{
+    std::stringstream out;
+    out << "//Generated by lib_config_codegen, do not edit\n"
+        << "#pragma once\n"
+        << "\n"
+        << "#include <lib_config/ConfigDecoder.hpp>\n"
+        << "#include <cstring>\n";
+    for(const std::string& include : includes){
+        out << "#include <" << include << ">\n";
+    }
+    out << "\nnamespace libConfig\n{\n\n";
+
+    for(const Typelib::Type* type : types)
+    {
+        if(type->getCategory() == Typelib::Type::Enum){
+            generateEnum(static_cast<const Typelib::Enum&>(*type), out);
+        }else{
+            generateCompound(static_cast<const Typelib::Compound&>(*type), out);
+        }
+    }
+    out << "}\n";
+    return out.str();
+}
+
+std::string CodeGenerator::cxxTypeName(const std::string &typelibName)
+{
+    std::string ret;
+    for(size_t i = 0; i < typelibName.size(); i++)
+    {
+        char c = typelibName[i];
+        if(c == '/'){
+            //A leading slash marks the root namespace
+            if(i != 0 && typelibName[i - 1] != '<' && typelibName[i - 1] != ','){
+                ret += "::";
+            }
+        }else{
+            ret += c;
+        }
+    }
+    return ret;
+}
@@ -0,0 +1,66 @@
+#ifndef CODE_GENERATOR_H
+#define CODE_GENERATOR_H
+
+#include <string>
+#include <vector>
+#include <set>
+
+namespace Typelib {
+class Registry;
+class Type;
+}
+
+namespace libConfig
+{
+
+/**
+ * @brief Generates ConfigDecoder specializations from Typelib types
+ *
+ * The generated header decodes configurations directly into the C++ types
+ * the Typelib registry was created from, without looking at the type model
+ * at runtime. Struct fields are dispatched on the length of their name and
+ * then by a string comparison, enums by comparing symbols. Numbers, strings,
+ * std::vector and arrays use the templates in ConfigDecoder.hpp, so the
+ * compiler can inline the whole decoding.
+ *
+ * Opaque, pointer and containers other than std::vector and std::string
+ * are not supported.
+ */
+class CodeGenerator
+{
+public:
+    /**
+     * @param registry: Registry the types are looked up in. Must outlive the
+     * generator.
+     */
+    CodeGenerator(const Typelib::Registry& registry);
+
+    //Header declaring the C++ types, included by the generated code
+    void addInclude(const std::string& header);
+
+    /**
+     * @brief Adds decoders for a type and all types it depends on
+     * Throws std::runtime_error if the type is not in the registry or is
+     * not supported.
+     */
+    void addType(const std::string& typeName);
+
+    //Returns the generated header
+    std::string generate() const;
+
+    //e.g. /std/vector</base/Angle> -> std::vector<base::Angle>
+    static std::string cxxTypeName(const std::string& typelibName);
+
+private:
+    const Typelib::Registry& registry;
+    std::vector<std::string> includes;
+    //Enums and compounds, dependencies first
+    std::vector<const Typelib::Type*> types;
+    std::set<const Typelib::Type*> visited;
+
+    void collect(const Typelib::Type& type);
+};
+
+}
+
+#endif // CODE_GENERATOR_H
@@ -0,0 +1,48 @@
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+#include <typelib/registry.hh>
+#include <typelib/pluginmanager.hh>
+#include "CodeGenerator.hpp"
+
+int main(int argc, char** argv)
+{
+    if(argc < 4)
+    {
+        std::cout << "Usage : lib_config_codegen <registry.tlb> <output.hpp> "
+                     "[-I <header>]... <type>..." << std::endl;
+        std::cout << "Generates ConfigDecoder specializations for the given "
+                     "Typelib types and the types they depend on" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        Typelib::Registry registry;
+        Typelib::PluginManager::load("tlb", argv[1], registry);
+
+        libConfig::CodeGenerator generator(registry);
+        for(int i = 3; i < argc; i++)
+        {
+            std::string arg = argv[i];
+            if(arg == "-I" && i + 1 < argc){
+                generator.addInclude(argv[++i]);
+            }else{
+                generator.addType(arg);
+            }
+        }
+
+        std::ofstream out(argv[2]);
+        out << generator.generate();
+        if(!out.good()){
+            std::cerr << "Could not write " << argv[2] << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return 0;
+}
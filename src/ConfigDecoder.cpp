@@ -0,0 +1,232 @@
+#include "ConfigDecoder.hpp"
+#include <limits>
+#include <cmath>
+#include <cerrno>
+#include <cstdlib>
+#include <stdexcept>
+#include <type_traits>
+
+namespace libConfig {
+
+namespace {
+
+template <class T>
+void parseSigned(const std::string& s, T& out, const ConfigPath* path)
+{
+    errno = 0;
+    char* end;
+    long long v = strtoll(s.c_str(), &end, 10);
+    if(s.empty() || *end != '\0'){
+        throwConfigError(path, "'" + s + "' is not an integer");
+    }
+    if(errno == ERANGE || v < std::numeric_limits<T>::min() ||
+       v > std::numeric_limits<T>::max())
+    {
+        throwConfigError(path, s + " is out of range");
+    }
+    out = static_cast<T>(v);
+}
+
+template <class T>
+void parseUnsigned(const std::string& s, T& out, const ConfigPath* path)
+{
+    //Booleans are unsigned integers of size 1 in Typelib
+    if(sizeof(T) == 1 && (s == "true" || s == "false")){
+        out = (s == "true");
+        return;
+    }
+
+    errno = 0;
+    char* end;
+    unsigned long long v = strtoull(s.c_str(), &end, 10);
+    if(s.empty() || *end != '\0'){
+        throwConfigError(path, "'" + s + "' is not an integer");
+    }
+    if(errno == ERANGE || s.find('-') != std::string::npos ||
+       v > std::numeric_limits<T>::max())
+    {
+        throwConfigError(path, s + " is out of range");
+    }
+    out = static_cast<T>(v);
+}
+
+template <class T>
+void parseFloat(const std::string& s, T& out, const ConfigPath* path)
+{
+    //Only long double is parsed with more precision than double
+    typedef typename std::conditional<(sizeof(T) > sizeof(double)), long double,
+                                      double>::type Parsed;
+    Parsed v;
+    if(s == ".inf" || s == "+.inf"){
+        v = std::numeric_limits<Parsed>::infinity();
+    }else if(s == "-.inf"){
+        v = -std::numeric_limits<Parsed>::infinity();
+    }else if(s == ".nan"){
+        v = std::numeric_limits<Parsed>::quiet_NaN();
+    }else{
+        errno = 0;
+        char* end;
+        if(sizeof(Parsed) > sizeof(double)){
+            v = strtold(s.c_str(), &end);
+        }else{
+            v = strtod(s.c_str(), &end);
+        }
+        if(s.empty() || *end != '\0'){
+            throwConfigError(path, "'" + s + "' is not a number");
+        }
+        //Underflow to denormals or zero is accepted
+        if(errno == ERANGE && std::isinf(v)){
+            throwConfigError(path, s + " is out of range");
+        }
+    }
+    if(std::isfinite(v) && std::fabs(v) > std::numeric_limits<T>::max()){
+        throwConfigError(path, s + " is out of range");
+    }
+    out = static_cast<T>(v);
+}
+}
+
+std::string ConfigPath::toString(const ConfigPath* path)
+{
+    std::vector<const ConfigPath*> elements;
+    for(; path; path = path->parent){
+        elements.push_back(path);
+    }
+
+    std::string ret;
+    for(std::vector<const ConfigPath*>::reverse_iterator it = elements.rbegin();
+        it != elements.rend(); ++it)
+    {
+        if((*it)->field){
+            if(!ret.empty()){
+                ret += ".";
+            }
+            ret += *(*it)->field;
+        }else{
+            ret += "[" + std::to_string((*it)->index) + "]";
+        }
+    }
+    return ret;
+}
+
+void throwConfigError(const ConfigPath* path, const std::string& msg)
+{
+    std::string where = ConfigPath::toString(path);
+    throw std::runtime_error("Cannot apply configuration" +
+                             (where.empty() ? std::string() : " to '" + where + "'") +
+                             ": " + msg);
+}
+
+const std::string& getConfigScalar(const ConfigValue& config, const std::string& typeName,
+                                   const ConfigPath* path)
+{
+    if(config.getType() != ConfigValue::SIMPLE){
+        throwConfigError(path, "expected a simple value for type " + typeName);
+    }
+    return static_cast<const SimpleConfigValue&>(config).getValue();
+}
+
+const ComplexConfigValue& getConfigMap(const ConfigValue& config, const std::string& typeName,
+                                       const ConfigPath* path)
+{
+    if(config.getType() != ConfigValue::COMPLEX){
+        throwConfigError(path, "expected a map for type " + typeName);
+    }
+    return static_cast<const ComplexConfigValue&>(config);
+}
+
+const std::vector<std::shared_ptr<ConfigValue> >& getConfigList(
+        const ConfigValue& config, const std::string& typeName, const ConfigPath* path)
+{
+    if(config.getType() != ConfigValue::ARRAY){
+        throwConfigError(path, "expected a list for type " + typeName);
+    }
+    return static_cast<const ArrayConfigValue&>(config).getValues();
+}
+
+void parseConfigNumber(const std::string& s, char& out, const ConfigPath* path)
+{
+    //The signedness of char depends on the platform
+    if(std::is_signed<char>::value){
+        parseSigned(s, out, path);
+    }else{
+        parseUnsigned(s, out, path);
+    }
+}
+
+void parseConfigNumber(const std::string& s, signed char& out, const ConfigPath* path)
+{
+    parseSigned(s, out, path);
+}
+
+void parseConfigNumber(const std::string& s, short& out, const ConfigPath* path)
+{
+    parseSigned(s, out, path);
+}
+
+void parseConfigNumber(const std::string& s, int& out, const ConfigPath* path)
+{
+    parseSigned(s, out, path);
+}
+
+void parseConfigNumber(const std::string& s, long& out, const ConfigPath* path)
+{
+    parseSigned(s, out, path);
+}
+
+void parseConfigNumber(const std::string& s, long long& out, const ConfigPath* path)
+{
+    parseSigned(s, out, path);
+}
+
+void parseConfigNumber(const std::string& s, unsigned char& out, const ConfigPath* path)
+{
+    parseUnsigned(s, out, path);
+}
+
+void parseConfigNumber(const std::string& s, unsigned short& out, const ConfigPath* path)
+{
+    parseUnsigned(s, out, path);
+}
+
+void parseConfigNumber(const std::string& s, unsigned int& out, const ConfigPath* path)
+{
+    parseUnsigned(s, out, path);
+}
+
+void parseConfigNumber(const std::string& s, unsigned long& out, const ConfigPath* path)
+{
+    parseUnsigned(s, out, path);
+}
+
+void parseConfigNumber(const std::string& s, unsigned long long& out, const ConfigPath* path)
+{
+    parseUnsigned(s, out, path);
+}
+
+void parseConfigNumber(const std::string& s, bool& out, const ConfigPath* path)
+{
+    uint8_t v;
+    parseUnsigned(s, v, path);
+    if(v > 1){
+        throwConfigError(path, s + " is not a boolean");
+    }
+    out = v;
+}
+
+void parseConfigNumber(const std::string& s, float& out, const ConfigPath* path)
+{
+    parseFloat(s, out, path);
+}
+
+void parseConfigNumber(const std::string& s, double& out, const ConfigPath* path)
+{
+    parseFloat(s, out, path);
+}
+
+void parseConfigNumber(const std::string& s, long double& out, const ConfigPath* path)
+{
+    parseFloat(s, out, path);
+}
+
+}
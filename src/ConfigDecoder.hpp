@@ -0,0 +1,164 @@
+#ifndef CONFIG_DECODER_H
+#define CONFIG_DECODER_H
+
+#include "Configuration.hpp"
+#include <cstdint>
+#include <type_traits>
+
+namespace libConfig
+{
+
+/**
+ * @brief Path of the element that is currently decoded
+ * Paths are built on the stack while descending and only turned into a
+ * string when an error is reported.
+ */
+struct ConfigPath
+{
+    const ConfigPath* parent;
+    //Field name, or nullptr for the element index of an array
+    const std::string* field;
+    size_t index;
+
+    //e.g. "transform.translation[2]"
+    static std::string toString(const ConfigPath* path);
+};
+
+//Throws std::runtime_error naming the path
+[[noreturn]] void throwConfigError(const ConfigPath* path, const std::string& msg);
+
+//Returns the value of a simple config value, throws for maps and lists
+const std::string& getConfigScalar(const ConfigValue& config, const std::string& typeName,
+                                   const ConfigPath* path);
+const ComplexConfigValue& getConfigMap(const ConfigValue& config, const std::string& typeName,
+                                       const ConfigPath* path);
+const std::vector<std::shared_ptr<ConfigValue> >& getConfigList(
+        const ConfigValue& config, const std::string& typeName, const ConfigPath* path);
+
+/**
+ * @brief Parses a configured number
+ * Throws std::runtime_error if the string is not a number of the target
+ * type or out of its range. Booleans and unsigned integers of size 1 also
+ * accept true and false, floating point values .inf, -.inf and .nan.
+ * There is an overload for every standard integer and floating point type,
+ * so that the fixed width typedefs and e.g. long long are covered on all
+ * platforms.
+ */
+void parseConfigNumber(const std::string& s, char& out, const ConfigPath* path);
+void parseConfigNumber(const std::string& s, signed char& out, const ConfigPath* path);
+void parseConfigNumber(const std::string& s, short& out, const ConfigPath* path);
+void parseConfigNumber(const std::string& s, int& out, const ConfigPath* path);
+void parseConfigNumber(const std::string& s, long& out, const ConfigPath* path);
+void parseConfigNumber(const std::string& s, long long& out, const ConfigPath* path);
+void parseConfigNumber(const std::string& s, unsigned char& out, const ConfigPath* path);
+void parseConfigNumber(const std::string& s, unsigned short& out, const ConfigPath* path);
+void parseConfigNumber(const std::string& s, unsigned int& out, const ConfigPath* path);
+void parseConfigNumber(const std::string& s, unsigned long& out, const ConfigPath* path);
+void parseConfigNumber(const std::string& s, unsigned long long& out, const ConfigPath* path);
+void parseConfigNumber(const std::string& s, bool& out, const ConfigPath* path);
+void parseConfigNumber(const std::string& s, float& out, const ConfigPath* path);
+void parseConfigNumber(const std::string& s, double& out, const ConfigPath* path);
+void parseConfigNumber(const std::string& s, long double& out, const ConfigPath* path);
+
+/**
+ * @brief Decodes a configuration value into a C++ object
+ *
+ * Numbers, std::string, std::vector and fixed size arrays are handled here.
+ * Specializations for enums and structs are generated by
+ * lib_config_codegen from Typelib type definitions; the struct
+ * specializations also provide decodeField(), which is used to decode the
+ * properties of a Configuration.
+ *
+ * Decoding follows TypelibConfiguration::applyToValue: fields that are not
+ * configured keep their value, vectors are resized to the number of
+ * configured elements and arrays may be configured partially.
+ */
+template <class T, class Enable = void>
+struct ConfigDecoder;
+
+template <class T>
+void decodeConfigValue(const ConfigValue& config, T& out, const ConfigPath* path)
+{
+    ConfigDecoder<T>::decode(config, out, path);
+}
+
+template <class T>
+struct ConfigDecoder<T, typename std::enable_if<std::is_arithmetic<T>::value>::type>
+{
+    static_assert(!std::is_same<T, wchar_t>::value && !std::is_same<T, char16_t>::value &&
+                  !std::is_same<T, char32_t>::value,
+                  "ConfigDecoder: wide character types cannot be configured");
+
+    static void decode(const ConfigValue& config, T& out, const ConfigPath* path)
+    {
+        parseConfigNumber(getConfigScalar(config, "number", path), out, path);
+    }
+};
+
+template <>
+struct ConfigDecoder<std::string>
+{
+    static void decode(const ConfigValue& config, std::string& out, const ConfigPath* path)
+    {
+        out = getConfigScalar(config, "/std/string", path);
+    }
+};
+
+template <class T, class Alloc>
+struct ConfigDecoder<std::vector<T, Alloc> >
+{
+    static void decode(const ConfigValue& config, std::vector<T, Alloc>& out,
+                       const ConfigPath* path)
+    {
+        const std::vector<std::shared_ptr<ConfigValue> >& elements =
+                getConfigList(config, "/std/vector", path);
+        out.resize(elements.size());
+        for(size_t i = 0; i < elements.size(); i++)
+        {
+            ConfigPath elementPath = {path, nullptr, i};
+            //No references into std::vector<bool>
+            T element = out[i];
+            decodeConfigValue(*elements[i], element, &elementPath);
+            out[i] = std::move(element);
+        }
+    }
+};
+
+template <class T, size_t N>
+struct ConfigDecoder<T[N]>
+{
+    static void decode(const ConfigValue& config, T (&out)[N], const ConfigPath* path)
+    {
+        const std::vector<std::shared_ptr<ConfigValue> >& elements =
+                getConfigList(config, "array", path);
+        if(elements.size() > N){
+            throwConfigError(path, "got " + std::to_string(elements.size()) +
+                             " elements for an array of size " + std::to_string(N));
+        }
+        for(size_t i = 0; i < elements.size(); i++)
+        {
+            ConfigPath elementPath = {path, nullptr, i};
+            decodeConfigValue(*elements[i], out[i], &elementPath);
+        }
+    }
+};
+
+//Decodes a configuration value, e.g. a single property
+template <class T>
+void decodeConfig(const ConfigValue& config, T& out)
+{
+    decodeConfigValue(config, out, nullptr);
+}
+
+//Decodes the properties of a configuration into the fields of a struct
+template <class T>
+void decodeConfig(const Configuration& config, T& out)
+{
+    for(const auto& it : config.getValues()){
+        ConfigDecoder<T>::decodeField(it.first, *it.second, out, nullptr);
+    }
+}
+
+}
+
+#endif // CONFIG_DECODER_H
@@ -1,5 +1,8 @@
 #include "Configuration.hpp"
 #include "YAMLConfiguration.hpp"
+#include "LoadTrace.hpp"
+#include "MemoryUsage.hpp"
+#include "AccessTracker.hpp"
 #include <iostream>
 #include <boost/filesystem.hpp>
 
@@ -87,7 +90,7 @@ bool ComplexConfigValue::merge(std::shared_ptr<ConfigValue> other)
 
 std::shared_ptr<ConfigValue> ComplexConfigValue::clone()
 {
-    ComplexConfigValue* copy = new ComplexConfigValue();
+    std::shared_ptr<ComplexConfigValue> copy = std::make_shared<ComplexConfigValue>();
     copy->type = type;
     copy->name = name;
     copy->cxxTypeName = cxxTypeName;
@@ -95,7 +98,7 @@ std::shared_ptr<ConfigValue> ComplexConfigValue::clone()
     {
         copy->values.insert(std::make_pair(it.first, it.second->clone()));
     }
-    return std::shared_ptr<ConfigValue>(copy);
+    return copy;
 }
 
 void ComplexConfigValue::addValue(const std::string &name, std::shared_ptr<ConfigValue> value)
@@ -103,6 +106,11 @@ void ComplexConfigValue::addValue(const std::string &name, std::shared_ptr<Confi
     values.insert(std::make_pair(name, value));
 }
 
+void ComplexConfigValue::setValue(const std::string &name, std::shared_ptr<ConfigValue> value)
+{
+    values[name] = value;
+}
+
 bool ComplexConfigValue::operator ==(const ConfigValue &other) const
 {
     if(other.getType() != ConfigValue::Type::COMPLEX){
@@ -121,7 +129,7 @@ bool ComplexConfigValue::operator ==(const ConfigValue &other) const
         }
         // The values to the same field are differnt
         std::shared_ptr<ConfigValue> val_a = val.second;
-        std::shared_ptr<ConfigValue> val_b = other_casted->getValues().at(val.first);
+        std::shared_ptr<ConfigValue> val_b = other_casted->values.at(val.first);
         if(*val_a != *val_b){
             return false;
         }
@@ -138,9 +146,22 @@ bool ComplexConfigValue::operator ==(const ConfigValue &other) const
 
 const std::map< std::string, std::shared_ptr<ConfigValue> >& ComplexConfigValue::getValues() const
 {
+    if(AccessTracker::isEnabled()){
+        AccessTracker::valueRead(this);
+    }
     return values;
 }
 
+size_t ComplexConfigValue::memoryUsage() const
+{
+    size_t bytes = sizeof(*this) + CONTROL_BLOCK_SIZE + baseMemoryUsage() +
+            mapNodesMemoryUsage(values);
+    for(const auto& it : values){
+        bytes += it.second->memoryUsage();
+    }
+    return bytes;
+}
+
 
 ArrayConfigValue::ArrayConfigValue(): ConfigValue(ARRAY)
 {
@@ -156,6 +177,33 @@ void ArrayConfigValue::addValue(std::shared_ptr<ConfigValue> value)
     values.push_back(value);
 }
 
+void ArrayConfigValue::reserve(size_t size)
+{
+    values.reserve(size);
+}
+
+void ArrayConfigValue::setValue(size_t index, std::shared_ptr<ConfigValue> value)
+{
+    values.at(index) = value;
+}
+
+size_t ArrayConfigValue::memoryUsage() const
+{
+    size_t bytes = sizeof(*this) + CONTROL_BLOCK_SIZE + baseMemoryUsage() +
+            values.capacity() * sizeof(std::shared_ptr<ConfigValue>);
+    for(const std::shared_ptr<ConfigValue>& value : values){
+        bytes += value->memoryUsage();
+    }
+    return bytes;
+}
+
+void ArrayConfigValue::truncate(size_t size)
+{
+    if(size < values.size()){
+        values.resize(size);
+    }
+}
+
 bool ArrayConfigValue::operator ==(const ConfigValue &other) const
 {
     if(other.getType() != ConfigValue::Type::ARRAY){
@@ -185,6 +233,9 @@ bool ArrayConfigValue::operator ==(const ConfigValue &other) const
 
 const std::vector<std::shared_ptr<ConfigValue> >& ArrayConfigValue::getValues() const
 {
+    if(AccessTracker::isEnabled()){
+        AccessTracker::valueRead(this);
+    }
     return values;
 }
 
@@ -240,7 +291,7 @@ bool ArrayConfigValue::merge(std::shared_ptr< ConfigValue > other)
 
 std::shared_ptr<ConfigValue> ArrayConfigValue::clone()
 {
-    ArrayConfigValue* copy = new ArrayConfigValue();
+    std::shared_ptr<ArrayConfigValue> copy = std::make_shared<ArrayConfigValue>();
     copy->type = type;
     copy->name = name;
     copy->cxxTypeName = cxxTypeName;
@@ -248,7 +299,7 @@ std::shared_ptr<ConfigValue> ArrayConfigValue::clone()
     {
         copy->values.push_back(entry->clone());
     }
-    return std::shared_ptr<ConfigValue>(copy);
+    return copy;
 }
 
 
@@ -269,9 +320,22 @@ SimpleConfigValue::~SimpleConfigValue()
 
 const std::string& SimpleConfigValue::getValue() const
 {
+    if(AccessTracker::isEnabled()){
+        AccessTracker::valueRead(this);
+    }
     return value;
 }
 
+void SimpleConfigValue::setValue(const char *v, size_t length)
+{
+    value.assign(v, length);
+}
+
+void SimpleConfigValue::setValue(const std::string &v)
+{
+    value = v;
+}
+
 bool SimpleConfigValue::operator ==(const ConfigValue &other) const
 {
     if(other.getType() != ConfigValue::Type::SIMPLE){
@@ -284,6 +348,11 @@ bool SimpleConfigValue::operator ==(const ConfigValue &other) const
     return this->value == other_casted->value;
 }
 
+size_t SimpleConfigValue::memoryUsage() const
+{
+    return sizeof(*this) + CONTROL_BLOCK_SIZE + baseMemoryUsage() + stringMemoryUsage(value);
+}
+
 void SimpleConfigValue::print(std::ostream &stream, int level) const
 {
     for(int i = 0; i < level; i++)
@@ -292,7 +361,8 @@ void SimpleConfigValue::print(std::ostream &stream, int level) const
 }
 
 YAML::Emitter& operator << (YAML::Emitter& out, const SimpleConfigValue& v) {
-    out << v.getValue();
+    //Not a read, see AccessTracker
+    out << v.value;
     return out;
 }
 
@@ -314,11 +384,11 @@ bool SimpleConfigValue::merge(const std::shared_ptr< ConfigValue > other)
 
 std::shared_ptr<ConfigValue> SimpleConfigValue::clone()
 {
-    SimpleConfigValue* copy = new SimpleConfigValue(value);
+    std::shared_ptr<SimpleConfigValue> copy = std::make_shared<SimpleConfigValue>(value);
     copy->type = type;
     copy->name = name;
     copy->cxxTypeName = cxxTypeName;
-    return std::shared_ptr<ConfigValue>(copy);
+    return copy;
 }
 
 ConfigValue::ConfigValue(Type t) : type(t)
@@ -328,7 +398,14 @@ ConfigValue::ConfigValue(Type t) : type(t)
 
 ConfigValue::~ConfigValue()
 {
+    if(AccessTracker::isEnabled()){
+        AccessTracker::valueDestroyed(this);
+    }
+}
 
+size_t ConfigValue::baseMemoryUsage() const
+{
+    return stringMemoryUsage(name) + stringMemoryUsage(cxxTypeName);
 }
 
 const ConfigValue::Type& ConfigValue::getType() const
@@ -416,6 +493,15 @@ const std::string& Configuration::getName() const
     return name;
 }
 
+size_t Configuration::memoryUsage() const
+{
+    size_t bytes = sizeof(*this) + stringMemoryUsage(name) + mapNodesMemoryUsage(values);
+    for(const auto& it : values){
+        bytes += it.second->memoryUsage();
+    }
+    return bytes;
+}
+
 bool Configuration::fillFromYaml(const std::string& yml)
 {
     values.clear();
@@ -499,6 +585,7 @@ bool MultiSectionConfiguration::load(std::string filepath)
 
 bool MultiSectionConfiguration::loadFromBundle(std::string filepath)
 {
+    LoadTrace::Span span("MultiSectionConfiguration::loadFromBundle", filepath);
     taskModelName = fs::path(filepath).stem().string();
     if(taskModelName.find("::") == std::string::npos){
         std::clog << "File " << taskModelName << " does not appear to be a oroGen " <<
@@ -536,6 +623,7 @@ Configuration MultiSectionConfiguration::getConfig(
         mergedConfigName += piece;
         first = false;
     };
+    LoadTrace::Span span("MultiSectionConfiguration::getConfig", taskModelName);
 
     Configuration result(mergedConfigName);
     for(const std::string &conf: sections){
@@ -547,12 +635,16 @@ Configuration MultiSectionConfiguration::getConfig(
                         "Task '" + taskModelName + "'");
         }
     }
+    if(AccessTracker::isEnabled()){
+        AccessTracker::configRequested(*this, sections, result);
+    }
     return result;
 }
 
 bool MultiSectionConfiguration::mergeConfigFile(
         const MultiSectionConfiguration &lowerPriorityFile)
 {
+    LoadTrace::Span span("MultiSectionConfiguration::mergeConfigFile", taskModelName);
     for(const std::pair<std::string, Configuration>& other : lowerPriorityFile.subsections)
     {
         const std::string& sectionName = other.first;
@@ -581,5 +673,16 @@ const bool MultiSectionConfiguration::hasConfigSection(const std::string &sectio
 {
     return subsections.find(section_name) != subsections.end();
 }
+
+size_t MultiSectionConfiguration::memoryUsage() const
+{
+    size_t bytes = sizeof(*this) + stringMemoryUsage(taskModelName) +
+            mapNodesMemoryUsage(subsections);
+    for(const auto& it : subsections){
+        //The configuration object itself is part of the map node
+        bytes += it.second.memoryUsage() - sizeof(Configuration);
+    }
+    return bytes;
+}
 }
 
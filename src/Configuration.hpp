@@ -37,6 +37,14 @@ public:
     virtual bool operator ==(const ConfigValue &other) const = 0;
     virtual bool operator !=(const ConfigValue &other) const;
 
+    /**
+     * @brief Approximate number of heap bytes used by this value and all
+     * values below it
+     * Includes the value object, its shared_ptr control block, strings and
+     * container storage. Allocator overhead is not included.
+     */
+    virtual size_t memoryUsage() const = 0;
+
     virtual ~ConfigValue();    
 protected:
     enum Type type;
@@ -44,6 +52,8 @@ protected:
     //C++ type representation name
     std::string cxxTypeName;
     ConfigValue(enum Type);
+    //Heap bytes of the members of ConfigValue, without the object itself
+    size_t baseMemoryUsage() const;
     friend YAML::Emitter& operator << (YAML::Emitter& out, const std::shared_ptr<ConfigValue>& v);
 };
 YAML::Emitter& operator << (YAML::Emitter& out, const std::shared_ptr<ConfigValue>& v);
@@ -59,7 +69,11 @@ public:
     virtual std::shared_ptr<ConfigValue> clone();
     
     const std::string &getValue() const;
+    //Reuses the existing string buffer if it is large enough
+    void setValue(const char *value, size_t length);
+    void setValue(const std::string &value);
     virtual bool operator ==(const ConfigValue &other) const;
+    virtual size_t memoryUsage() const;
 private:
     std::string value;
     friend YAML::Emitter& operator << (YAML::Emitter& out, const SimpleConfigValue& v);
@@ -76,7 +90,10 @@ public:
     virtual std::shared_ptr<ConfigValue> clone();
     const std::map<std::string, std::shared_ptr<ConfigValue>> &getValues() const;
     void addValue(const std::string &name, std::shared_ptr<ConfigValue> value);
+    //Like addValue, but replaces an existing value with the same name
+    void setValue(const std::string &name, std::shared_ptr<ConfigValue> value);
     bool operator ==(const ConfigValue &other) const;
+    virtual size_t memoryUsage() const;
 private:
     friend YAML::Emitter& operator << (YAML::Emitter& out, const ComplexConfigValue& v);
     std::map<std::string, std::shared_ptr<ConfigValue>> values;
@@ -93,7 +110,13 @@ public:
     virtual std::shared_ptr<ConfigValue> clone();
     const std::vector<std::shared_ptr<ConfigValue> >& getValues() const;
     void addValue(std::shared_ptr<ConfigValue> value);
+    //Preallocates storage for the given number of elements
+    void reserve(size_t size);
+    void setValue(size_t index, std::shared_ptr<ConfigValue> value);
+    //Removes all elements from index size on
+    void truncate(size_t size);
     bool operator ==(const ConfigValue &other) const;
+    virtual size_t memoryUsage() const;
 private:
     std::vector<std::shared_ptr<ConfigValue> > values;
     friend YAML::Emitter& operator << (YAML::Emitter& out, const ArrayConfigValue& v);
@@ -119,6 +142,9 @@ public:
     const std::string &getName() const;
     const std::map<std::string, std::shared_ptr<ConfigValue> > &getValues() const;
     void addValue(const std::string &name, std::shared_ptr<ConfigValue> value);    
+    //Approximate heap bytes of the configuration object and its values, see
+    //ConfigValue::memoryUsage()
+    size_t memoryUsage() const;
 private:
     std::string name;
     std::map<std::string, std::shared_ptr<ConfigValue> > values;
@@ -146,6 +172,8 @@ public:
     std::string taskModelName;
     const std::map<std::string, Configuration>& getSubsections() const;
     const bool hasConfigSection(const std::string& section_name) const;
+    //Approximate heap bytes of the object and all its sections
+    size_t memoryUsage() const;
 protected:
     //Maps a configuration subsection name to Configuration
     std::map<std::string, Configuration> subsections;
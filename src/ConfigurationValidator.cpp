@@ -0,0 +1,94 @@
+#include "ConfigurationValidator.hpp"
+#include "Bundle.hpp"
+#include "TypelibConfiguration.hpp"
+#include "LoadTrace.hpp"
+#include <typelib/registry.hh>
+#include "ParallelFor.hpp"
+#include <stdexcept>
+
+using namespace libConfig;
+
+ConfigurationValidator::ConfigurationValidator(const Typelib::Registry &registry) :
+    registry(registry)
+{
+}
+
+void ConfigurationValidator::addTaskModel(const std::string &taskModelName,
+                                          const std::map<std::string, std::string> &propertyTypes)
+{
+    taskModels[taskModelName] = propertyTypes;
+}
+
+void ConfigurationValidator::validateTask(const TaskConfigurations &configurations,
+                                          const std::string &taskModelName,
+                                          TypelibConfiguration typelibConfig,
+                                          std::vector<ValidationError> &errors) const
+{
+    LoadTrace::Span span("ConfigurationValidator::validateTask", taskModelName);
+    const std::map<std::string, std::string>& properties = taskModels.at(taskModelName);
+    std::shared_ptr<const MultiSectionConfiguration> multiConfig;
+    try{
+        multiConfig = configurations.getMultiConfigPtr(taskModelName);
+    }catch(const std::out_of_range&){
+        //Removed by a reload since the task list was taken
+        return;
+    }
+    std::vector<std::string> messages;
+
+    for(const auto& section : multiConfig->getSubsections())
+    {
+        for(const auto& property : section.second.getValues())
+        {
+            std::map<std::string, std::string>::const_iterator type =
+                    properties.find(property.first);
+            if(type == properties.end()){
+                messages.push_back("Task model has no property '" + property.first + "'");
+            }else if(const Typelib::Type* t = registry.get(type->second)){
+                std::vector<std::string> propertyErrors;
+                typelibConfig.validate(*property.second, *t, propertyErrors);
+                for(const std::string& msg : propertyErrors){
+                    messages.push_back("Property '" + property.first + "': " + msg);
+                }
+            }else{
+                messages.push_back("Type " + type->second + " of property '" +
+                                   property.first + "' is not in the registry");
+            }
+        }
+        for(const std::string& msg : messages){
+            errors.push_back(ValidationError{taskModelName, section.first, msg});
+        }
+        messages.clear();
+    }
+}
+
+std::vector<ValidationError> ConfigurationValidator::validate(
+        const TaskConfigurations &configurations, unsigned threads) const
+{
+    LoadTrace::Span span("ConfigurationValidator::validate");
+    std::vector<std::string> tasks;
+    for(const std::string& name : configurations.getTaskModelNames()){
+        if(taskModels.count(name)){
+            tasks.push_back(name);
+        }
+    }
+
+    //One result slot per task keeps the output independent of scheduling
+    std::vector<std::vector<ValidationError> > results(tasks.size());
+    const TypelibConfiguration typelibConfig(registry);
+    parallelFor(tasks.size(), threads, [&](size_t i){
+        //E.g. parse errors of lazily loaded files, fn must not throw
+        try{
+            validateTask(configurations, tasks[i], typelibConfig, results[i]);
+        }catch(const std::exception& e){
+            results[i].push_back(ValidationError{tasks[i], "", e.what()});
+        }catch(...){
+            results[i].push_back(ValidationError{tasks[i], "", "Unknown error"});
+        }
+    });
+
+    std::vector<ValidationError> errors;
+    for(std::vector<ValidationError>& r : results){
+        errors.insert(errors.end(), r.begin(), r.end());
+    }
+    return errors;
+}
@@ -0,0 +1,76 @@
+#ifndef CONFIGURATION_VALIDATOR_H
+#define CONFIGURATION_VALIDATOR_H
+
+#include <string>
+#include <vector>
+#include <map>
+
+namespace Typelib {
+class Registry;
+}
+
+namespace libConfig
+{
+
+class TaskConfigurations;
+class TypelibConfiguration;
+
+struct ValidationError
+{
+    std::string taskModelName;
+    //Empty if the configuration of the task model could not be loaded
+    std::string section;
+    std::string message;
+};
+
+/**
+ * @brief Checks the task configurations of a bundle against the Typelib
+ * types of the task properties
+ *
+ * Every section of every task model with known property types is checked
+ * for unknown properties and fields, type mismatches, bad enum symbols and
+ * malformed or out-of-range numbers, i.e. everything that would otherwise
+ * only fail when the component is configured. Task models are validated in
+ * parallel.
+ */
+class ConfigurationValidator
+{
+public:
+    /**
+     * @param registry: Registry the property types are looked up in. Must
+     * outlive the validator.
+     */
+    ConfigurationValidator(const Typelib::Registry& registry);
+
+    /**
+     * @brief Declares the properties of a task model
+     * @param propertyTypes: Maps property names to Typelib type names
+     */
+    void addTaskModel(const std::string& taskModelName,
+                      const std::map<std::string, std::string>& propertyTypes);
+
+    /**
+     * @brief Validates all task models that have configurations and
+     * declared properties. Configurations of undeclared task models are
+     * skipped. Task models whose configuration cannot be loaded, e.g. due
+     * to parse errors in lazy loading mode, are reported as one error.
+     * @param threads: Number of worker threads, 0 uses one per core
+     * @return The errors, ordered by task model, section and property
+     */
+    std::vector<ValidationError> validate(const TaskConfigurations& configurations,
+                                          unsigned threads = 0) const;
+
+private:
+    const Typelib::Registry& registry;
+    std::map<std::string, std::map<std::string, std::string> > taskModels;
+
+    //typelibConfig caches the plans of the registry for all tasks
+    void validateTask(const TaskConfigurations& configurations,
+                      const std::string& taskModelName,
+                      TypelibConfiguration typelibConfig,
+                      std::vector<ValidationError>& errors) const;
+};
+
+}
+
+#endif // CONFIGURATION_VALIDATOR_H
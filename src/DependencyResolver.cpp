@@ -0,0 +1,261 @@
+#include "DependencyResolver.hpp"
+#include "LoadTrace.hpp"
+#include "ParallelFor.hpp"
+#include "FileStamp.hpp"
+#include <boost/filesystem.hpp>
+#include <base-logging/Logging.hpp>
+#include <unordered_map>
+#include <unordered_set>
+#include <exception>
+#include <algorithm>
+
+namespace fs = boost::filesystem;
+using namespace libConfig;
+
+namespace
+{
+struct Node
+{
+    SingleBundle bundle;
+    std::vector<std::string> dependencies;
+    //Reported when the bundle is reached in priority order, so that the
+    //same error as without the graph is thrown
+    std::exception_ptr resolveError;
+    std::exception_ptr loadError;
+    //Taken before the bundle.yml is read
+    std::vector<FileStamp> stamps;
+};
+
+std::string bundleConfigFile(const SingleBundle& bundle)
+{
+    return (fs::path(bundle.path) / "config" / "bundle.yml").string();
+}
+
+void loadDependencies(Node& node)
+{
+    node.stamps.push_back(FileStamp(node.bundle.path));
+    node.stamps.push_back(FileStamp((fs::path(node.bundle.path) / "config").string()));
+    node.stamps.push_back(FileStamp(bundleConfigFile(node.bundle)));
+    if(node.bundle.configDir.empty() || !fs::exists(bundleConfigFile(node.bundle))){
+        // No bundle.yml file exists.
+        // We assume that this bundle has no depending bundles
+        LOG_INFO_S << "Bundle '" + node.bundle.name + "' does not contain a bundle" <<
+                     " configuration file '." << bundleConfigFile(node.bundle);
+        return;
+    }
+    node.dependencies = Bundle::loadDependenciesFromYAML(bundleConfigFile(node.bundle));
+}
+
+//Appends the dependencies of node that were not seen yet, then continues
+//with each of them. This is the order the recursive discovery always had.
+void appendDependencies(const Node& node,
+                        const std::unordered_map<std::string, Node>& nodes,
+                        std::unordered_set<std::string>& seen,
+                        std::vector<const Node*>& order)
+{
+    if(node.loadError){
+        std::rethrow_exception(node.loadError);
+    }
+    std::vector<const Node*> added;
+    for(const std::string& name : node.dependencies)
+    {
+        if(!seen.insert(name).second){
+            continue;
+        }
+        const Node& dep = nodes.at(name);
+        if(dep.resolveError){
+            std::rethrow_exception(dep.resolveError);
+        }
+        order.push_back(&dep);
+        added.push_back(&dep);
+    }
+    for(const Node* dep : added){
+        appendDependencies(*dep, nodes, seen, order);
+    }
+}
+
+void findCycles(size_t idx, BundleDependencyGraph& graph, std::vector<int>& state,
+                std::vector<size_t>& stack)
+{
+    //0: not visited, 1: on the stack, 2: done
+    state[idx] = 1;
+    stack.push_back(idx);
+    for(size_t dep : graph.dependencies[idx])
+    {
+        if(state[dep] == 1){
+            std::vector<std::string> cycle;
+            std::vector<size_t>::const_iterator it =
+                    std::find(stack.begin(), stack.end(), dep);
+            for(; it != stack.end(); ++it){
+                cycle.push_back(graph.bundles[*it].name);
+            }
+            cycle.push_back(graph.bundles[dep].name);
+            graph.cycles.push_back(cycle);
+        }else if(state[dep] == 0){
+            findCycles(dep, graph, state, stack);
+        }
+    }
+    stack.pop_back();
+    state[idx] = 2;
+}
+
+std::string cacheKey(const SingleBundle& bundle, const std::vector<std::string>& searchPaths)
+{
+    std::string key = bundle.path;
+    for(const std::string& path : searchPaths){
+        key += '\n' + path;
+    }
+    return key;
+}
+}
+
+struct DependencyResolver::CacheEntry
+{
+    std::shared_ptr<const BundleDependencyGraph> graph;
+    std::vector<FileStamp> stamps;
+};
+
+DependencyResolver::DependencyResolver(unsigned threads) :
+    threads(threads), cacheHits(0)
+{
+}
+
+std::shared_ptr<const BundleDependencyGraph> DependencyResolver::resolve(
+        const SingleBundle &bundle, const std::vector<std::string> &searchPaths)
+{
+    LoadTrace::Span span("DependencyResolver::resolve", bundle.name);
+    const std::string key = cacheKey(bundle, searchPaths);
+    std::shared_ptr<const CacheEntry> cached;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::map<std::string, std::shared_ptr<const CacheEntry> >::const_iterator it =
+                cache.find(key);
+        if(it != cache.end()){
+            cached = it->second;
+        }
+    }
+    if(cached)
+    {
+        bool valid = true;
+        for(const FileStamp& stamp : cached->stamps){
+            if(!stamp.isCurrent()){
+                valid = false;
+                break;
+            }
+        }
+        if(valid){
+            std::lock_guard<std::mutex> lock(mutex);
+            cacheHits++;
+            return cached->graph;
+        }
+    }
+
+    std::shared_ptr<const CacheEntry> entry = build(bundle, searchPaths);
+    std::lock_guard<std::mutex> lock(mutex);
+    cache[key] = entry;
+    return entry->graph;
+}
+
+std::shared_ptr<const DependencyResolver::CacheEntry> DependencyResolver::build(
+        const SingleBundle &bundle, const std::vector<std::string> &searchPaths) const
+{
+    //Stamps are taken before reading, so changes made while the graph is
+    //built invalidate it on the next call
+    std::shared_ptr<CacheEntry> entry = std::make_shared<CacheEntry>();
+    for(const std::string& path : searchPaths){
+        entry->stamps.push_back(FileStamp(path));
+    }
+
+    std::unordered_map<std::string, Node> nodes;
+    Node& root = nodes[bundle.name];
+    root.bundle = bundle;
+
+    //Breadth-first, the bundles of one level are resolved and their
+    //bundle.yml files loaded concurrently
+    std::unordered_set<std::string> seen;
+    seen.insert(bundle.name);
+    std::vector<Node*> level(1, &root);
+    bool isRoot = true;
+    while(!level.empty())
+    {
+        parallelFor(level.size(), threads, [&](size_t i)
+        {
+            Node& node = *level[i];
+            if(!isRoot){
+                try{
+                    node.bundle = SingleBundle::fromNameAndSearchPaths(
+                                node.bundle.name, searchPaths);
+                }catch(...){
+                    node.resolveError = std::current_exception();
+                    return;
+                }
+            }
+            try{
+                loadDependencies(node);
+            }catch(...){
+                node.loadError = std::current_exception();
+            }
+        });
+        isRoot = false;
+
+        std::vector<Node*> next;
+        for(Node* node : level){
+            for(const std::string& name : node->dependencies)
+            {
+                if(seen.insert(name).second){
+                    Node& dep = nodes[name];
+                    dep.bundle.name = name;
+                    next.push_back(&dep);
+                }
+            }
+        }
+        level.swap(next);
+    }
+
+    std::vector<const Node*> order(1, &root);
+    seen.clear();
+    seen.insert(bundle.name);
+    appendDependencies(root, nodes, seen, order);
+
+    std::shared_ptr<BundleDependencyGraph> graph = std::make_shared<BundleDependencyGraph>();
+    std::unordered_map<std::string, size_t> index;
+    for(const Node* node : order){
+        index[node->bundle.name] = graph->bundles.size();
+        graph->bundles.push_back(node->bundle);
+        entry->stamps.insert(entry->stamps.end(), node->stamps.begin(), node->stamps.end());
+    }
+    for(const Node* node : order)
+    {
+        std::vector<size_t> deps;
+        for(const std::string& name : node->dependencies){
+            deps.push_back(index.at(name));
+        }
+        graph->dependencies.push_back(deps);
+    }
+
+    std::vector<int> state(graph->bundles.size(), 0);
+    std::vector<size_t> stack;
+    findCycles(0, *graph, state, stack);
+    for(const std::vector<std::string>& cycle : graph->cycles)
+    {
+        std::string path;
+        for(const std::string& name : cycle){
+            path += (path.empty() ? "" : " -> ") + name;
+        }
+        LOG_WARN_S << "Cyclic bundle dependency " << path << ". The cycle is ignored.";
+    }
+    entry->graph = graph;
+    return entry;
+}
+
+void DependencyResolver::clearCache()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    cache.clear();
+}
+
+size_t DependencyResolver::getCacheHits() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return cacheHits;
+}
@@ -0,0 +1,78 @@
+#ifndef DEPENDENCY_RESOLVER_H
+#define DEPENDENCY_RESOLVER_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include "Bundle.hpp"
+
+namespace libConfig
+{
+
+/**
+ * @brief Resolved dependencies of a bundle
+ */
+struct BundleDependencyGraph
+{
+    //The bundle and all its direct and indirect dependencies with decreasing
+    //priority, the bundle itself first
+    std::vector<SingleBundle> bundles;
+    //Direct dependencies of each bundle as indices into bundles, in the order
+    //they are listed in its bundle.yml
+    std::vector<std::vector<size_t> > dependencies;
+    //Each cycle as the names of the bundles along it, the first name is
+    //repeated at the end
+    std::vector<std::vector<std::string> > cycles;
+};
+
+/**
+ * @brief Builds the dependency graph of a bundle from the config/bundle.yml
+ * files
+ *
+ * The bundle.yml files of one level of the graph are loaded concurrently.
+ * The priority order is the one Bundle::discoverDependencies always had:
+ * the direct dependencies of a bundle follow it, then the dependencies of
+ * each of them are resolved in turn. Cycles are reported as warnings.
+ *
+ * Resolved graphs are cached. A cached graph is used again as long as the
+ * search paths, the bundle directories and the bundle.yml files were not
+ * modified, which is checked with one stat per path.
+ *
+ * All methods are thread-safe.
+ */
+class DependencyResolver
+{
+public:
+    //Number of threads loading bundle.yml files, 0 uses one per core
+    DependencyResolver(unsigned threads = 0);
+
+    /**
+     * @brief Resolves the dependencies of the given bundle
+     * Throws std::runtime_error if a dependency is not found in the search
+     * paths or a bundle.yml cannot be parsed, like the bundle resolution
+     * without cache.
+     */
+    std::shared_ptr<const BundleDependencyGraph> resolve(
+            const SingleBundle& bundle, const std::vector<std::string>& searchPaths);
+
+    void clearCache();
+    //Number of resolve() calls answered from the cache
+    size_t getCacheHits() const;
+
+private:
+    struct CacheEntry;
+
+    unsigned threads;
+    mutable std::mutex mutex;
+    std::map<std::string, std::shared_ptr<const CacheEntry> > cache;
+    size_t cacheHits;
+
+    std::shared_ptr<const CacheEntry> build(
+            const SingleBundle& bundle, const std::vector<std::string>& searchPaths) const;
+};
+
+}
+
+#endif // DEPENDENCY_RESOLVER_H
@@ -0,0 +1,164 @@
+#include "DirectoryScanner.hpp"
+#include "LoadTrace.hpp"
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <algorithm>
+#include <dirent.h>
+#include <sys/stat.h>
+
+using namespace libConfig;
+
+namespace
+{
+
+struct Job
+{
+    std::string path;
+    ScannedDirectory* directory;
+};
+
+class JobQueue
+{
+public:
+    JobQueue() : pending(0)
+    {
+    }
+
+    void push(Job&& job)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(std::move(job));
+        pending++;
+        cond.notify_one();
+    }
+
+    //Returns false when all jobs are done
+    bool pop(Job& job)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cond.wait(lock, [this]{ return !jobs.empty() || pending == 0; });
+        if(jobs.empty()){
+            return false;
+        }
+        job = std::move(jobs.front());
+        jobs.pop_front();
+        return true;
+    }
+
+    void done()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if(--pending == 0){
+            cond.notify_all();
+        }
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::deque<Job> jobs;
+    //Jobs queued or running
+    size_t pending;
+};
+
+//Returns false if the entry does not exist, e.g. a broken symlink
+bool classify(const std::string& path, unsigned char type, ScannedEntry::Kind& kind)
+{
+    struct stat st;
+    if(type == DT_UNKNOWN){
+        if(lstat(path.c_str(), &st) != 0){
+            return false;
+        }
+        type = S_ISLNK(st.st_mode) ? DT_LNK : S_ISDIR(st.st_mode) ? DT_DIR :
+               S_ISREG(st.st_mode) ? DT_REG : DT_FIFO;
+    }
+
+    switch(type)
+    {
+        case DT_REG:
+            kind = ScannedEntry::FILE;
+            return true;
+        case DT_DIR:
+            kind = ScannedEntry::DIRECTORY;
+            return true;
+        case DT_LNK:
+            if(stat(path.c_str(), &st) != 0){
+                return false;
+            }
+            kind = S_ISDIR(st.st_mode) ? ScannedEntry::LINKED_DIRECTORY :
+                   S_ISREG(st.st_mode) ? ScannedEntry::FILE : ScannedEntry::OTHER;
+            return true;
+        default:
+            kind = ScannedEntry::OTHER;
+            return true;
+    }
+}
+
+void list(const Job& job, const std::vector<std::string>& skip, JobQueue& queue)
+{
+    DIR* dir = opendir(job.path.c_str());
+    if(!dir){
+        return;
+    }
+    while(struct dirent* ent = readdir(dir))
+    {
+        const char* name = ent->d_name;
+        if(name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))){
+            continue;
+        }
+        ScannedEntry entry;
+        entry.name = name;
+        std::string path = job.path + "/" + entry.name;
+        if(!classify(path, ent->d_type, entry.kind)){
+            continue;
+        }
+        if(entry.kind == ScannedEntry::DIRECTORY &&
+           std::find(skip.begin(), skip.end(), entry.name) == skip.end())
+        {
+            entry.content.reset(new ScannedDirectory());
+            queue.push(Job{path, entry.content.get()});
+        }
+        job.directory->entries.push_back(std::move(entry));
+    }
+    closedir(dir);
+}
+}
+
+DirectoryScanner::DirectoryScanner(unsigned threads) :
+    threads(threads ? threads : std::max(1u, std::thread::hardware_concurrency()))
+{
+}
+
+std::vector<std::unique_ptr<ScannedDirectory> > DirectoryScanner::scan(
+        const std::vector<std::string> &roots, const std::vector<std::string> &skip)
+{
+    LoadTrace::Span span("DirectoryScanner::scan");
+    std::vector<std::unique_ptr<ScannedDirectory> > ret;
+    JobQueue queue;
+    for(const std::string& root : roots)
+    {
+        ret.emplace_back(new ScannedDirectory());
+        queue.push(Job{root, ret.back().get()});
+    }
+
+    auto worker = [&]()
+    {
+        Job job;
+        while(queue.pop(job))
+        {
+            list(job, skip, queue);
+            queue.done();
+        }
+    };
+    std::vector<std::thread> workers;
+    for(unsigned i = 1; i < threads; i++){
+        workers.emplace_back(worker);
+    }
+    worker();
+    for(std::thread& t : workers){
+        t.join();
+    }
+    return ret;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+
+namespace libConfig
+{
+
+struct ScannedDirectory;
+
+struct ScannedEntry
+{
+    enum Kind {
+        FILE,
+        DIRECTORY,
+        //Symlink to a directory, its content is not scanned
+        LINKED_DIRECTORY,
+        //Existing entry that is neither a regular file nor a directory
+        OTHER,
+    };
+    std::string name;
+    Kind kind;
+    //Content of a DIRECTORY, nullptr if it was skipped
+    std::unique_ptr<ScannedDirectory> content;
+};
+
+struct ScannedDirectory
+{
+    //In the order returned by the filesystem
+    std::vector<ScannedEntry> entries;
+};
+
+/**
+ * @brief Lists directory trees concurrently on a pool of worker threads
+ *
+ * Every directory is a separate job, so the subtrees of one root are
+ * scanned in parallel as well. Entry types are taken from the d_type field
+ * returned by readdir, which spares one stat call per entry on filesystems
+ * that provide it. Symlinks are resolved with stat but not descended.
+ * Broken symlinks and directories that cannot be read are skipped.
+ */
+class DirectoryScanner
+{
+public:
+    //@param threads: Number of worker threads, 0 uses one per core. With one
+    //thread scan() runs on the calling thread only.
+    explicit DirectoryScanner(unsigned threads = 0);
+
+    /**
+     * @brief Scans the given roots
+     * @param skip: Names of directories that are not descended at any
+     *        depth, e.g. ".git". They are listed without content.
+     * @return One tree per root, in the order of the roots. Roots that are
+     *         not directories give empty trees.
+     */
+    std::vector<std::unique_ptr<ScannedDirectory> > scan(
+            const std::vector<std::string>& roots,
+            const std::vector<std::string>& skip = std::vector<std::string>());
+
+private:
+    unsigned threads;
+};
+
+}
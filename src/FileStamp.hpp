@@ -0,0 +1,54 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <sys/stat.h>
+
+namespace libConfig
+{
+
+/**
+ * @brief Identifies the version of a file or directory with a single stat.
+ * Creating, removing or renaming an entry of a directory changes its
+ * modification time.
+ */
+struct FileStamp
+{
+    std::string path;
+    bool exists;
+    int64_t mtime;
+    int64_t ctime;
+    int64_t size;
+    uint64_t inode;
+
+    FileStamp() : exists(false), mtime(0), ctime(0), size(0), inode(0)
+    {
+    }
+
+    explicit FileStamp(const std::string& path) :
+        path(path), exists(false), mtime(0), ctime(0), size(0), inode(0)
+    {
+        struct stat st;
+        if(stat(path.c_str(), &st) == 0){
+            exists = true;
+            mtime = int64_t(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+            ctime = int64_t(st.st_ctim.tv_sec) * 1000000000 + st.st_ctim.tv_nsec;
+            size = st.st_size;
+            inode = st.st_ino;
+        }
+    }
+
+    bool operator==(const FileStamp& other) const
+    {
+        return exists == other.exists && mtime == other.mtime &&
+                ctime == other.ctime && size == other.size && inode == other.inode;
+    }
+
+    //True if the path was not modified since the stamp was taken
+    bool isCurrent() const
+    {
+        return FileStamp(path) == *this;
+    }
+};
+
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+#include <sstream>
+#include <iomanip>
+
+namespace libConfig
+{
+
+//Quotes and escapes a string for use in hand written JSON output
+inline std::string jsonString(const std::string& in)
+{
+    std::stringstream ss;
+    ss << '"';
+    for(char c : in){
+        switch(c){
+            case '"': ss << "\\\""; break;
+            case '\\': ss << "\\\\"; break;
+            case '\n': ss << "\\n"; break;
+            case '\t': ss << "\\t"; break;
+            default:
+                if(static_cast<unsigned char>(c) < 0x20){
+                    ss << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+                       << static_cast<int>(c) << std::dec;
+                }else{
+                    ss << c;
+                }
+        }
+    }
+    ss << '"';
+    return ss.str();
+}
+
+}
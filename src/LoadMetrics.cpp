@@ -0,0 +1,267 @@
+#include "LoadMetrics.hpp"
+#include "Configuration.hpp"
+#include "JsonUtils.hpp"
+#include <mutex>
+#include <sstream>
+#include <iomanip>
+
+using namespace libConfig;
+
+std::atomic<bool> LoadMetrics::enabled(false);
+
+namespace
+{
+std::atomic<LoadMetrics::AllocationCounter> allocationCounter(nullptr);
+std::mutex reportMutex;
+LoadMetricsReport report;
+//Innermost open file scope of the calling thread
+thread_local LoadMetrics::FileScope* currentFile = nullptr;
+
+double secondsSince(const std::chrono::steady_clock::time_point& start)
+{
+    return std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - start).count();
+}
+
+size_t countNodes(const ConfigValue& value)
+{
+    size_t count = 1;
+    if(value.getType() == ConfigValue::COMPLEX){
+        const ComplexConfigValue& c = static_cast<const ComplexConfigValue&>(value);
+        for(const auto& it : c.getValues()){
+            count += countNodes(*it.second);
+        }
+    }else if(value.getType() == ConfigValue::ARRAY){
+        const ArrayConfigValue& a = static_cast<const ArrayConfigValue&>(value);
+        for(const std::shared_ptr<ConfigValue>& v : a.getValues()){
+            count += countNodes(*v);
+        }
+    }
+    return count;
+}
+}
+
+SectionLoadMetrics::SectionLoadMetrics() :
+    bytes(0), nodeCount(0), allocations(0), insertionTime(0), parseTime(0)
+{
+}
+
+FileLoadMetrics::FileLoadMetrics() :
+    bytesRead(0), nodeCount(0), allocations(0), loadTime(0)
+{
+}
+
+BundleInitMetrics::BundleInitMetrics() :
+    searchPathResolution(0), dependencyDiscovery(0), fileIndexing(0), taskConfigLoading(0),
+    total(0), activeBundles(0), succeeded(false)
+{
+}
+
+std::string LoadMetricsReport::toJson() const
+{
+    std::stringstream ss;
+    ss << std::setprecision(9);
+    ss << "{\n  \"initializations\": [";
+    for(size_t i = 0; i < initializations.size(); i++)
+    {
+        const BundleInitMetrics& m = initializations[i];
+        ss << (i ? ",\n" : "\n") << "    {"
+           << "\"searchPathResolution\": " << m.searchPathResolution
+           << ", \"dependencyDiscovery\": " << m.dependencyDiscovery
+           << ", \"fileIndexing\": " << m.fileIndexing
+           << ", \"taskConfigLoading\": " << m.taskConfigLoading
+           << ", \"total\": " << m.total
+           << ", \"activeBundles\": " << m.activeBundles
+           << ", \"succeeded\": " << (m.succeeded ? "true" : "false") << "}";
+    }
+    ss << (initializations.empty() ? "" : "\n  ") << "],\n  \"files\": [";
+    for(size_t i = 0; i < files.size(); i++)
+    {
+        const FileLoadMetrics& f = files[i];
+        ss << (i ? ",\n" : "\n") << "    {"
+           << "\"path\": " << jsonString(f.path)
+           << ", \"bytesRead\": " << f.bytesRead
+           << ", \"nodeCount\": " << f.nodeCount
+           << ", \"allocations\": " << f.allocations
+           << ", \"loadTime\": " << f.loadTime
+           << ", \"sections\": [";
+        for(size_t j = 0; j < f.sections.size(); j++)
+        {
+            const SectionLoadMetrics& s = f.sections[j];
+            ss << (j ? ", " : "") << "{"
+               << "\"name\": " << jsonString(s.name)
+               << ", \"bytes\": " << s.bytes
+               << ", \"nodeCount\": " << s.nodeCount
+               << ", \"allocations\": " << s.allocations
+               << ", \"insertionTime\": " << s.insertionTime
+               << ", \"parseTime\": " << s.parseTime << "}";
+        }
+        ss << "]}";
+    }
+    ss << (files.empty() ? "" : "\n  ") << "]\n}\n";
+    return ss.str();
+}
+
+void LoadMetrics::setEnabled(bool enable)
+{
+    enabled.store(enable);
+}
+
+void LoadMetrics::setAllocationCounter(AllocationCounter counter)
+{
+    allocationCounter.store(counter);
+}
+
+void LoadMetrics::reset()
+{
+    std::lock_guard<std::mutex> lock(reportMutex);
+    report = LoadMetricsReport();
+}
+
+LoadMetricsReport LoadMetrics::getReport()
+{
+    std::lock_guard<std::mutex> lock(reportMutex);
+    return report;
+}
+
+size_t LoadMetrics::allocations()
+{
+    AllocationCounter counter = allocationCounter.load();
+    return counter ? counter() : 0;
+}
+
+void LoadMetrics::record(const FileLoadMetrics &file)
+{
+    std::lock_guard<std::mutex> lock(reportMutex);
+    report.files.push_back(file);
+}
+
+void LoadMetrics::record(const BundleInitMetrics &init)
+{
+    std::lock_guard<std::mutex> lock(reportMutex);
+    report.initializations.push_back(init);
+}
+
+LoadMetrics::FileScope::FileScope(const std::string &path) :
+    active(isEnabled()), startAllocations(0), parent(nullptr)
+{
+    if(!active){
+        return;
+    }
+    metrics.path = path;
+    parent = currentFile;
+    currentFile = this;
+    startAllocations = allocations();
+    start = std::chrono::steady_clock::now();
+}
+
+LoadMetrics::FileScope::~FileScope()
+{
+    if(!active){
+        return;
+    }
+    metrics.loadTime = secondsSince(start);
+    metrics.allocations = allocations() - startAllocations;
+    currentFile = parent;
+    record(metrics);
+}
+
+void LoadMetrics::FileScope::setBytesRead(size_t bytes)
+{
+    metrics.bytesRead = bytes;
+}
+
+LoadMetrics::SectionScope::SectionScope(const std::string &name, size_t bytes) :
+    active(isEnabled() && currentFile != nullptr), startAllocations(0)
+{
+    if(!active){
+        return;
+    }
+    metrics.name = name;
+    metrics.bytes = bytes;
+    startAllocations = allocations();
+    start = std::chrono::steady_clock::now();
+}
+
+LoadMetrics::SectionScope::~SectionScope()
+{
+    if(!active){
+        return;
+    }
+    metrics.allocations = allocations() - startAllocations;
+    currentFile->metrics.nodeCount += metrics.nodeCount;
+    currentFile->metrics.sections.push_back(metrics);
+}
+
+void LoadMetrics::SectionScope::insertionDone()
+{
+    if(!active){
+        return;
+    }
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    metrics.insertionTime = std::chrono::duration<double>(now - start).count();
+    start = now;
+}
+
+void LoadMetrics::SectionScope::parsed(const Configuration &config)
+{
+    if(!active){
+        return;
+    }
+    metrics.parseTime = secondsSince(start);
+    for(const auto& it : config.getValues()){
+        metrics.nodeCount += countNodes(*it.second);
+    }
+}
+
+LoadMetrics::InitializationScope::InitializationScope() :
+    active(isEnabled())
+{
+    if(!active){
+        return;
+    }
+    start = std::chrono::steady_clock::now();
+    last = start;
+}
+
+LoadMetrics::InitializationScope::~InitializationScope()
+{
+    if(!active){
+        return;
+    }
+    metrics.total = secondsSince(start);
+    record(metrics);
+}
+
+void LoadMetrics::InitializationScope::phaseDone(Phase phase)
+{
+    if(!active){
+        return;
+    }
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    double duration = std::chrono::duration<double>(now - last).count();
+    last = now;
+    switch(phase){
+        case SEARCH_PATH_RESOLUTION:
+            metrics.searchPathResolution = duration;
+            break;
+        case DEPENDENCY_DISCOVERY:
+            metrics.dependencyDiscovery = duration;
+            break;
+        case FILE_INDEXING:
+            metrics.fileIndexing = duration;
+            break;
+        case TASK_CONFIG_LOADING:
+            metrics.taskConfigLoading = duration;
+            break;
+    }
+}
+
+void LoadMetrics::InitializationScope::succeeded(size_t activeBundles)
+{
+    if(!active){
+        return;
+    }
+    metrics.activeBundles = activeBundles;
+    metrics.succeeded = true;
+}
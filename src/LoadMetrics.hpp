@@ -0,0 +1,155 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <atomic>
+#include <cstddef>
+
+namespace libConfig
+{
+
+class Configuration;
+
+struct SectionLoadMetrics
+{
+    std::string name;
+    //Size of the section text before variable insertion
+    size_t bytes;
+    //Number of ConfigValue nodes created for the section
+    size_t nodeCount;
+    //Heap allocations, only counted if an allocation counter is set
+    size_t allocations;
+    //Time in seconds spent in applyStringVariableInsertions
+    double insertionTime;
+    //Time in seconds spent parsing the YAML into a Configuration
+    double parseTime;
+
+    SectionLoadMetrics();
+};
+
+struct FileLoadMetrics
+{
+    std::string path;
+    size_t bytesRead;
+    size_t nodeCount;
+    size_t allocations;
+    //Time in seconds for reading, splitting and parsing the whole file
+    double loadTime;
+    std::vector<SectionLoadMetrics> sections;
+
+    FileLoadMetrics();
+};
+
+struct BundleInitMetrics
+{
+    //Times in seconds of the phases of Bundle::initialize
+    double searchPathResolution;
+    double dependencyDiscovery;
+    double fileIndexing;
+    double taskConfigLoading;
+    double total;
+    size_t activeBundles;
+    bool succeeded;
+
+    BundleInitMetrics();
+};
+
+struct LoadMetricsReport
+{
+    std::vector<BundleInitMetrics> initializations;
+    std::vector<FileLoadMetrics> files;
+
+    std::string toJson() const;
+};
+
+/**
+ * @brief Collects timing and size information while loading configurations
+ *
+ * Collection is disabled by default. While disabled, instrumented code only
+ * checks an atomic flag. The collected data is process wide and can be
+ * queried with getReport() from any thread.
+ */
+class LoadMetrics
+{
+public:
+    //Returns the current number of heap allocations of the process. The
+    //library does not replace operator new itself, so applications that want
+    //allocation counts have to provide the counter.
+    typedef size_t (*AllocationCounter)();
+
+    static void setEnabled(bool enabled);
+    static bool isEnabled()
+    {
+        return enabled.load(std::memory_order_relaxed);
+    }
+    static void setAllocationCounter(AllocationCounter counter);
+    static void reset();
+    static LoadMetricsReport getReport();
+
+    class SectionScope;
+
+    /**
+     * @brief Records the metrics of one configuration file. Sections
+     * recorded by SectionScope on the same thread are attached to the
+     * innermost open FileScope.
+     */
+    class FileScope
+    {
+    public:
+        FileScope(const std::string& path);
+        ~FileScope();
+        void setBytesRead(size_t bytes);
+    private:
+        bool active;
+        std::chrono::steady_clock::time_point start;
+        size_t startAllocations;
+        FileLoadMetrics metrics;
+        FileScope* parent;
+        friend class SectionScope;
+    };
+
+    class SectionScope
+    {
+    public:
+        SectionScope(const std::string& name, size_t bytes);
+        ~SectionScope();
+        //Call after variable insertion is done and parsing starts
+        void insertionDone();
+        void parsed(const Configuration& config);
+    private:
+        bool active;
+        std::chrono::steady_clock::time_point start;
+        size_t startAllocations;
+        SectionLoadMetrics metrics;
+    };
+
+    class InitializationScope
+    {
+    public:
+        enum Phase {
+            SEARCH_PATH_RESOLUTION,
+            DEPENDENCY_DISCOVERY,
+            FILE_INDEXING,
+            TASK_CONFIG_LOADING,
+        };
+        InitializationScope();
+        ~InitializationScope();
+        //Ends the given phase, it is timed from the end of the previous one
+        void phaseDone(Phase phase);
+        void succeeded(size_t activeBundles);
+    private:
+        bool active;
+        std::chrono::steady_clock::time_point start;
+        std::chrono::steady_clock::time_point last;
+        BundleInitMetrics metrics;
+    };
+
+private:
+    static std::atomic<bool> enabled;
+    static size_t allocations();
+    static void record(const FileLoadMetrics& file);
+    static void record(const BundleInitMetrics& init);
+};
+
+}
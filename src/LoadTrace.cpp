@@ -0,0 +1,173 @@
+#include "LoadTrace.hpp"
+#include "JsonUtils.hpp"
+#include <mutex>
+#include <vector>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <base-logging/Logging.hpp>
+
+using namespace libConfig;
+
+std::atomic<bool> LoadTrace::enabled(false);
+
+namespace
+{
+struct TraceEvent
+{
+    const char* name;
+    std::string detail;
+    long tid;
+    int64_t start;
+    int64_t duration;
+};
+
+//Holds the recorded events and writes them on exit if LIB_CONFIG_TRACE is set
+struct TraceBuffer
+{
+    std::mutex mutex;
+    std::vector<TraceEvent> events;
+    std::string outputPath;
+
+    TraceBuffer()
+    {
+        const char* path = getenv("LIB_CONFIG_TRACE");
+        if(path && path[0] != '\0'){
+            outputPath = path;
+            std::string::size_type pos = outputPath.find("%p");
+            if(pos != std::string::npos){
+                outputPath.replace(pos, 2, std::to_string(getpid()));
+            }
+            LoadTrace::setEnabled(true);
+        }
+    }
+
+    ~TraceBuffer()
+    {
+        if(!outputPath.empty()){
+            LoadTrace::setEnabled(false);
+            LoadTrace::writeJson(outputPath);
+        }
+    }
+};
+
+TraceBuffer& buffer()
+{
+    static TraceBuffer instance;
+    return instance;
+}
+
+//Makes sure LIB_CONFIG_TRACE is evaluated when the library is loaded
+const TraceBuffer& initBuffer = buffer();
+
+int64_t now()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+long threadId()
+{
+    thread_local long tid = syscall(SYS_gettid);
+    return tid;
+}
+
+std::string processName()
+{
+    std::ifstream comm("/proc/self/comm");
+    std::string name;
+    std::getline(comm, name);
+    return name;
+}
+}
+
+void LoadTrace::setEnabled(bool enable)
+{
+    enabled.store(enable);
+}
+
+void LoadTrace::reset()
+{
+    TraceBuffer& b = buffer();
+    std::lock_guard<std::mutex> lock(b.mutex);
+    b.events.clear();
+}
+
+std::string LoadTrace::toJson()
+{
+    std::vector<TraceEvent> events;
+    {
+        TraceBuffer& b = buffer();
+        std::lock_guard<std::mutex> lock(b.mutex);
+        events = b.events;
+    }
+
+    const int pid = getpid();
+    std::stringstream ss;
+    ss << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    ss << "  {\"name\": \"process_name\", \"ph\": \"M\", \"pid\": " << pid <<
+          ", \"args\": {\"name\": " << jsonString(processName() + " (" +
+                                                 std::to_string(pid) + ")") << "}}";
+    for(const TraceEvent& ev : events)
+    {
+        ss << ",\n  {\"name\": " << jsonString(ev.name)
+           << ", \"cat\": \"lib_config\", \"ph\": \"X\""
+           << ", \"ts\": " << ev.start << ", \"dur\": " << ev.duration
+           << ", \"pid\": " << pid << ", \"tid\": " << ev.tid;
+        if(!ev.detail.empty()){
+            ss << ", \"args\": {\"detail\": " << jsonString(ev.detail) << "}";
+        }
+        ss << "}";
+    }
+    ss << "\n]}\n";
+    return ss.str();
+}
+
+bool LoadTrace::writeJson(const std::string &path)
+{
+    std::ofstream out(path.c_str());
+    if(!out){
+        LOG_ERROR_S << "Could not write trace file " << path;
+        return false;
+    }
+    out << toJson();
+    return out.good();
+}
+
+LoadTrace::Span::Span(const char *name) :
+    name(name), active(isEnabled()), start(0)
+{
+    if(active){
+        start = now();
+    }
+}
+
+LoadTrace::Span::Span(const char *name, const std::string &detail) :
+    name(name), active(isEnabled()), start(0)
+{
+    if(active){
+        this->detail = detail;
+        start = now();
+    }
+}
+
+LoadTrace::Span::~Span()
+{
+    if(!active){
+        return;
+    }
+    TraceEvent ev;
+    ev.name = name;
+    ev.detail.swap(detail);
+    ev.tid = threadId();
+    ev.start = start;
+    ev.duration = now() - start;
+
+    TraceBuffer& b = buffer();
+    std::lock_guard<std::mutex> lock(b.mutex);
+    b.events.push_back(ev);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <string>
+#include <atomic>
+#include <cstdint>
+
+namespace libConfig
+{
+
+/**
+ * @brief Records spans of the configuration loading in the Chrome
+ * trace-event format, which can be opened in chrome://tracing or Perfetto
+ *
+ * Timestamps are taken from the monotonic system clock, so traces written
+ * by different processes on the same machine can be loaded into one viewer
+ * and compared side by side.
+ *
+ * Tracing is disabled by default. It can be enabled programmatically or by
+ * setting the environment variable LIB_CONFIG_TRACE to an output file. In
+ * the latter case the trace is written when the process exits. A '%p' in
+ * the file name is replaced by the process id.
+ */
+class LoadTrace
+{
+public:
+    static void setEnabled(bool enabled);
+    static bool isEnabled()
+    {
+        return enabled.load(std::memory_order_relaxed);
+    }
+    static void reset();
+    static std::string toJson();
+    static bool writeJson(const std::string& path);
+
+    /**
+     * @brief Complete event covering the lifetime of the object
+     * @param name: Span name, has to be a string literal
+     * @param detail: Optional argument shown with the span, e.g. a file name
+     */
+    class Span
+    {
+    public:
+        Span(const char* name);
+        Span(const char* name, const std::string& detail);
+        ~Span();
+    private:
+        const char* name;
+        std::string detail;
+        bool active;
+        int64_t start;
+    };
+
+private:
+    static std::atomic<bool> enabled;
+};
+
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+
+namespace libConfig
+{
+
+//Estimates of the heap used by the standard containers, for the
+//memoryUsage() methods. The numbers match libstdc++: a shared_ptr control
+//block holds a vtable pointer and two counters, a map node three pointers
+//and the color besides its element.
+const size_t CONTROL_BLOCK_SIZE = sizeof(void*) + 2 * sizeof(int);
+const size_t MAP_NODE_OVERHEAD = 4 * sizeof(void*);
+
+inline size_t stringMemoryUsage(const std::string& str)
+{
+    //Short strings are stored inside the string object
+    static const size_t inlineCapacity = std::string().capacity();
+    return str.capacity() > inlineCapacity ? str.capacity() + 1 : 0;
+}
+
+inline size_t stringsMemoryUsage(const std::vector<std::string>& strings)
+{
+    size_t bytes = strings.capacity() * sizeof(std::string);
+    for(const std::string& str : strings){
+        bytes += stringMemoryUsage(str);
+    }
+    return bytes;
+}
+
+//Heap bytes of the nodes of a map with string keys, without the heap used
+//by the mapped values
+template <class T>
+size_t mapNodesMemoryUsage(const std::map<std::string, T>& map)
+{
+    size_t bytes = 0;
+    for(const auto& it : map){
+        bytes += MAP_NODE_OVERHEAD + sizeof(it) + stringMemoryUsage(it.first);
+    }
+    return bytes;
+}
+
+}
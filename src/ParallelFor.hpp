@@ -0,0 +1,41 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+
+namespace libConfig
+{
+
+/**
+ * @brief Calls fn(i) for every i in [0, count) on up to the given number of
+ * threads, 0 uses one per core. The calling thread takes part in the work.
+ * fn must not throw; collect errors per index instead.
+ */
+template <class Fn>
+void parallelFor(size_t count, unsigned threads, Fn fn)
+{
+    if(threads == 0){
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = std::min<size_t>(threads, count);
+
+    std::atomic<size_t> next(0);
+    auto worker = [&]()
+    {
+        for(size_t i = next++; i < count; i = next++){
+            fn(i);
+        }
+    };
+    std::vector<std::thread> workers;
+    for(unsigned i = 1; i < threads; i++){
+        workers.emplace_back(worker);
+    }
+    worker();
+    for(std::thread& t : workers){
+        t.join();
+    }
+}
+
+}
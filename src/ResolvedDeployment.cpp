@@ -0,0 +1,255 @@
+#include "ResolvedDeployment.hpp"
+#include "YAMLConfiguration.hpp"
+#include "LoadTrace.hpp"
+#include "ParallelFor.hpp"
+#include <yaml-cpp/yaml.h>
+#include <fstream>
+#include <sstream>
+#include <exception>
+#include <stdexcept>
+#include <algorithm>
+
+using namespace libConfig;
+
+namespace
+{
+const std::string SECTION_PREFIX = "--- name:";
+
+std::vector<std::string> sectionList(const YAML::Node& node, const std::string& entry)
+{
+    if(!node.IsSequence()){
+        throw std::runtime_error("The sections of deployment entry '" + entry +
+                                 "' have to be a list");
+    }
+    std::vector<std::string> sections;
+    for(const YAML::Node& section : node){
+        sections.push_back(section.as<std::string>());
+    }
+    return sections;
+}
+
+//Same as the name MultiSectionConfiguration::getConfig() gives the result
+std::string joinSections(const std::vector<std::string>& sections)
+{
+    std::string ret;
+    for(const std::string& section : sections){
+        ret += (ret.empty() ? "" : ",") + section;
+    }
+    return ret;
+}
+
+//The first line of each section records where the configuration came from:
+//'# <task model> <section>,<section>...'
+std::string originComment(const DeploymentEntry& entry)
+{
+    return "# " + entry.taskModelName + " " + joinSections(entry.sections);
+}
+
+void parseOriginComment(const std::string& line, DeploymentEntry& entry)
+{
+    std::vector<std::string> parts = Bundle::tokenize(line.substr(1), " ");
+    if(parts.size() == 2){
+        entry.taskModelName = parts[0];
+        entry.sections = Bundle::tokenize(parts[1], ",");
+    }
+}
+}
+
+std::vector<DeploymentEntry> ResolvedDeployment::loadDescription(const std::string &path)
+{
+    std::ifstream fin(path);
+    if(!fin){
+        throw std::runtime_error("Could not read deployment description " + path);
+    }
+    std::stringstream ss;
+    ss << fin.rdbuf();
+    return parseDescription(ss.str());
+}
+
+std::vector<DeploymentEntry> ResolvedDeployment::parseDescription(const std::string &yaml)
+{
+    YAML::Node doc = YAML::Load(yaml);
+    if(!doc.IsMap()){
+        throw std::runtime_error("A deployment description has to be a map of "
+                                 "task names or task models to sections");
+    }
+    std::vector<DeploymentEntry> ret;
+    for(const auto& it : doc)
+    {
+        DeploymentEntry entry;
+        entry.name = it.first.as<std::string>();
+        if(it.second.IsMap())
+        {
+            if(!it.second["model"]){
+                throw std::runtime_error("Deployment entry '" + entry.name +
+                                         "' does not give a task model");
+            }
+            entry.taskModelName = it.second["model"].as<std::string>();
+            if(it.second["sections"]){
+                entry.sections = sectionList(it.second["sections"], entry.name);
+            }
+        }else{
+            entry.taskModelName = entry.name;
+            entry.sections = sectionList(it.second, entry.name);
+        }
+        if(entry.sections.empty()){
+            entry.sections.push_back("default");
+        }
+        ret.push_back(entry);
+    }
+    return ret;
+}
+
+void ResolvedDeployment::resolve(const TaskConfigurations &taskConfigurations,
+                                 const std::vector<DeploymentEntry> &entries,
+                                 unsigned threads)
+{
+    LoadTrace::Span span("ResolvedDeployment::resolve");
+    for(size_t i = 0; i < entries.size(); i++){
+        for(size_t j = 0; j < i; j++){
+            if(entries[i].name == entries[j].name){
+                throw std::runtime_error("Deployment entry '" + entries[i].name +
+                                         "' is given twice");
+            }
+        }
+    }
+
+    //Task models are loaded first, so that a task model that is deployed
+    //several times is only parsed once
+    std::vector<std::string> models;
+    for(const DeploymentEntry& entry : entries){
+        if(std::find(models.begin(), models.end(), entry.taskModelName) == models.end()){
+            models.push_back(entry.taskModelName);
+        }
+    }
+    parallelFor(models.size(), threads, [&](size_t i){
+        try{
+            taskConfigurations.getMultiConfig(models[i]);
+        }catch(...){
+            //Reported by the entry below
+        }
+    });
+
+    std::vector<Configuration> merged(entries.size());
+    std::vector<std::exception_ptr> errors(entries.size());
+    parallelFor(entries.size(), threads, [&](size_t i){
+        try{
+            merged[i] = taskConfigurations.getConfig(entries[i].taskModelName,
+                                                     entries[i].sections);
+        }catch(...){
+            errors[i] = std::current_exception();
+        }
+    });
+    for(const std::exception_ptr& error : errors){
+        if(error){
+            std::rethrow_exception(error);
+        }
+    }
+
+    std::map<std::string, Configuration> resolved;
+    for(size_t i = 0; i < entries.size(); i++){
+        resolved.emplace(entries[i].name, merged[i]);
+    }
+    this->entries = entries;
+    configs.swap(resolved);
+}
+
+std::string ResolvedDeployment::toYaml() const
+{
+    std::string ret;
+    for(const DeploymentEntry& entry : entries)
+    {
+        YAML::Emitter emitter;
+        emitter << configs.at(entry.name);
+        ret += SECTION_PREFIX + entry.name + "\n" + originComment(entry) + "\n" +
+                emitter.c_str() + "\n";
+    }
+    return ret;
+}
+
+void ResolvedDeployment::save(const std::string &path) const
+{
+    std::ofstream fout(path);
+    fout << toYaml();
+    fout.close();
+    if(!fout){
+        throw std::runtime_error("Could not write resolved deployment " + path);
+    }
+}
+
+void ResolvedDeployment::load(const std::string &path)
+{
+    std::ifstream fin(path);
+    if(!fin){
+        throw std::runtime_error("Could not read resolved deployment " + path);
+    }
+    std::stringstream ss;
+    ss << fin.rdbuf();
+    loadString(ss.str());
+}
+
+void ResolvedDeployment::loadString(const std::string &yaml)
+{
+    LoadTrace::Span span("ResolvedDeployment::load");
+    std::vector<DeploymentEntry> loadedEntries;
+    std::vector<std::string> buffers;
+    std::istringstream stream(yaml);
+    std::string line;
+    while(std::getline(stream, line))
+    {
+        if(!line.compare(0, SECTION_PREFIX.size(), SECTION_PREFIX)){
+            DeploymentEntry entry;
+            entry.name = line.substr(SECTION_PREFIX.size());
+            loadedEntries.push_back(entry);
+            buffers.push_back(std::string());
+        }else if(loadedEntries.empty()){
+            if(!line.empty()){
+                throw std::runtime_error("Sections must begin with '--- name:<SectionName>'");
+            }
+        }else{
+            if(buffers.back().empty() && !line.empty() && line[0] == '#'){
+                parseOriginComment(line, loadedEntries.back());
+            }
+            buffers.back() += line + "\n";
+        }
+    }
+
+    //The values were resolved when the file was written, so no string
+    //variable insertions are applied
+    YAMLConfigParser parser;
+    std::map<std::string, Configuration> loaded;
+    for(size_t i = 0; i < loadedEntries.size(); i++)
+    {
+        const DeploymentEntry& entry = loadedEntries[i];
+        Configuration config(entry.sections.empty() ? entry.name : joinSections(entry.sections));
+        if(!parser.parseYAML(config, buffers[i])){
+            throw std::runtime_error("Could not parse the configuration of deployment entry '" +
+                                     entry.name + "'");
+        }
+        if(!loaded.emplace(entry.name, config).second){
+            throw std::runtime_error("Deployment entry '" + entry.name +
+                                     "' is given twice");
+        }
+    }
+    entries.swap(loadedEntries);
+    configs.swap(loaded);
+}
+
+bool ResolvedDeployment::hasConfig(const std::string &name) const
+{
+    return configs.count(name) > 0;
+}
+
+const Configuration& ResolvedDeployment::getConfig(const std::string &name) const
+{
+    std::map<std::string, Configuration>::const_iterator it = configs.find(name);
+    if(it == configs.end()){
+        throw std::out_of_range("No resolved configuration for deployment entry " + name + " found.");
+    }
+    return it->second;
+}
+
+const std::vector<DeploymentEntry>& ResolvedDeployment::getEntries() const
+{
+    return entries;
+}
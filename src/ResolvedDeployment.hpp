@@ -0,0 +1,88 @@
+#ifndef RESOLVED_DEPLOYMENT_H
+#define RESOLVED_DEPLOYMENT_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include "Configuration.hpp"
+#include "Bundle.hpp"
+
+namespace libConfig
+{
+
+/**
+ * @brief A deployed task and the sections its configuration is built from
+ */
+struct DeploymentEntry
+{
+    //Name the configuration is stored under, e.g. the name of the task
+    std::string name;
+    std::string taskModelName;
+    //Sorted with increasing priority, as for TaskConfigurations::getConfig()
+    std::vector<std::string> sections;
+};
+
+/**
+ * @brief Merged task configurations of a deployment, resolved in advance
+ *
+ * resolve() merges the configurations of all entries of a deployment
+ * description. save() writes them into a single file with one
+ * '--- name:<entry>' section per entry, so that the file can also be read
+ * with MultiSectionConfiguration::loadNoBundle(). load() reads such a file
+ * without applying string variable insertions again and without a bundle,
+ * which is all that is needed at boot time.
+ */
+class ResolvedDeployment
+{
+public:
+    /**
+     * @brief Loads a deployment description
+     * The description is a YAML map. A key with a list of sections as value
+     * is a task model name, the entry has the same name:
+     *
+     *   camera_usb::Task: [default, left]
+     *
+     * A key with a map as value is the entry name, the map gives the task
+     * model and the sections. The sections default to 'default':
+     *
+     *   left_camera:
+     *     model: camera_usb::Task
+     *     sections: [default, left]
+     *
+     * Throws std::runtime_error on malformed descriptions.
+     */
+    static std::vector<DeploymentEntry> loadDescription(const std::string& path);
+    static std::vector<DeploymentEntry> parseDescription(const std::string& yaml);
+
+    /**
+     * @brief Merges the configuration of each entry
+     * The task models of the entries are loaded and merged concurrently on
+     * the given number of threads, 0 uses one per core. With lazy loading
+     * only the files of these task models are parsed. If an entry cannot be
+     * resolved, the error of the first of them in the given order is
+     * rethrown.
+     */
+    void resolve(const TaskConfigurations& taskConfigurations,
+                 const std::vector<DeploymentEntry>& entries,
+                 unsigned threads = 0);
+
+    std::string toYaml() const;
+    void save(const std::string& path) const;
+    //Throws std::runtime_error if the file cannot be read or parsed
+    void load(const std::string& path);
+    void loadString(const std::string& yaml);
+
+    bool hasConfig(const std::string& name) const;
+    //Throws std::out_of_range if there is no entry with the given name
+    const Configuration& getConfig(const std::string& name) const;
+    //In the order of the description
+    const std::vector<DeploymentEntry>& getEntries() const;
+
+private:
+    std::vector<DeploymentEntry> entries;
+    std::map<std::string, Configuration> configs;
+};
+
+}
+
+#endif // RESOLVED_DEPLOYMENT_H
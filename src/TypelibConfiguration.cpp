@@ -1,204 +1,910 @@
 #include "TypelibConfiguration.hpp"
+#include "TypelibPlan.hpp"
+#include "ConfigDecoder.hpp"
 #include <typelib/typevisitor.hh>
-#include <boost/lexical_cast.hpp>
+#include <typelib/value_ops.hh>
 
 namespace libConfig {
 
-std::shared_ptr< ConfigValue > TypelibConfiguration::getFromValue(Typelib::Value& value)
+namespace {
+
+std::shared_ptr<ConfigValue> convert(const TypelibPlan& plan, const uint8_t* data)
 {
-    const Typelib::Type &type(value.getType());
+    switch(plan.kind)
+    {
+        case TypelibPlan::INT8:
+        case TypelibPlan::INT16:
+        case TypelibPlan::INT32:
+        case TypelibPlan::INT64:
+        case TypelibPlan::UINT8:
+        case TypelibPlan::UINT16:
+        case TypelibPlan::UINT32:
+        case TypelibPlan::UINT64:
+        case TypelibPlan::FLOAT:
+        case TypelibPlan::DOUBLE:
+        {
+            char buffer[TypelibPlan::NUMERIC_BUFFER_SIZE];
+            size_t len = plan.formatNumeric(data, buffer);
+            std::shared_ptr<SimpleConfigValue> config =
+                    std::make_shared<SimpleConfigValue>(std::string(buffer, len));
+            config->setCxxTypeName(plan.typeName);
+            return config;
+        }
+        case TypelibPlan::ENUM:
+        {
+            Typelib::Enum::integral_type intVal =
+                    *reinterpret_cast<const Typelib::Enum::integral_type*>(data);
+            std::unordered_map<Typelib::Enum::integral_type, std::string>::const_iterator it =
+                    plan.enumSymbols.find(intVal);
+            if(it == plan.enumSymbols.end()){
+                throw std::runtime_error("Value " + std::to_string(intVal) +
+                                         " is not valid for enum " + plan.typeName);
+            }
+            std::shared_ptr<SimpleConfigValue> config =
+                    std::make_shared<SimpleConfigValue>(it->second);
+            config->setCxxTypeName(plan.typeName);
+            return config;
+        }
+        case TypelibPlan::STRING:
+        {
+            std::shared_ptr<SimpleConfigValue> config = std::make_shared<SimpleConfigValue>(
+                        *reinterpret_cast<const std::string*>(data));
+            config->setCxxTypeName(plan.typeName);
+            return config;
+        }
+        case TypelibPlan::COMPOUND:
+        {
+            std::shared_ptr<ComplexConfigValue> config = std::make_shared<ComplexConfigValue>();
+            config->setCxxTypeName(plan.typeName);
+            for(const TypelibPlan::Field& field : plan.fields)
+            {
+                std::shared_ptr<ConfigValue> convV = convert(*field.plan, data + field.offset);
+                convV->setName(field.name);
+                config->addValue(field.name, convV);
+            }
+            return config;
+        }
+        case TypelibPlan::ARRAY:
+        {
+            std::shared_ptr<ArrayConfigValue> config = std::make_shared<ArrayConfigValue>();
+            config->setCxxTypeName(plan.typeName);
+            config->reserve(plan.dimension);
+            for(size_t i = 0; i < plan.dimension; i++)
+            {
+                config->addValue(convert(*plan.element, data + i * plan.elementSize));
+            }
+            return config;
+        }
+        case TypelibPlan::CONTAINER:
+        {
+            const Typelib::Container& cont = *plan.container;
+            void* ptr = const_cast<uint8_t*>(data);
+            const size_t size = cont.getElementCount(ptr);
+
+            std::shared_ptr<ArrayConfigValue> config = std::make_shared<ArrayConfigValue>();
+            config->setCxxTypeName(plan.typeName);
+            config->reserve(size);
+            for(size_t i = 0; i < size; i++)
+            {
+                Typelib::Value elem = cont.getElement(ptr, i);
+                config->addValue(convert(*plan.element,
+                                         static_cast<const uint8_t*>(elem.getData())));
+            }
+            return config;
+        }
+        case TypelibPlan::UNSUPPORTED:
+            break;
+    }
+
+    if(plan.type->getCategory() == Typelib::Type::Numeric){
+        throw std::runtime_error("got numeric " + plan.typeName + " of unexpected size " +
+                                 std::to_string(plan.size));
+    }
+    std::shared_ptr<SimpleConfigValue> config(new SimpleConfigValue("Nothing"));
+    config->setName("Unsupported");
     
-    switch(type.getCategory())
+    return config;    
+}
+
+//Checks if an existing node has the type getFromValue creates for the plan
+bool nodeMatches(const TypelibPlan& plan, const ConfigValue& config)
+{
+    switch(plan.kind)
     {
-        case Typelib::Type::Array:
-            return getFromArray(value);
+        case TypelibPlan::COMPOUND:
+            return config.getType() == ConfigValue::COMPLEX;
+        case TypelibPlan::ARRAY:
+        case TypelibPlan::CONTAINER:
+            return config.getType() == ConfigValue::ARRAY;
+        default:
+            return config.getType() == ConfigValue::SIMPLE;
+    }
+}
+
+bool updateScalar(SimpleConfigValue& config, const char* value, size_t length)
+{
+    const std::string& current = config.getValue();
+    if(current.size() == length && current.compare(0, length, value, length) == 0){
+        return false;
+    }
+    config.setValue(value, length);
+    return true;
+}
+
+bool update(const TypelibPlan& plan, const uint8_t* data, ConfigValue& config);
+
+//Updates the element at index or appends it if the array is too short
+bool updateElement(const TypelibPlan& plan, const uint8_t* data,
+                   ArrayConfigValue& array, size_t index)
+{
+    if(index < array.getValues().size())
+    {
+        ConfigValue& element = *array.getValues()[index];
+        if(nodeMatches(plan, element)){
+            return update(plan, data, element);
+        }
+        array.setValue(index, convert(plan, data));
+    }else{
+        array.addValue(convert(plan, data));
+    }
+    return true;
+}
+
+bool update(const TypelibPlan& plan, const uint8_t* data, ConfigValue& config)
+{
+    switch(plan.kind)
+    {
+        case TypelibPlan::INT8:
+        case TypelibPlan::INT16:
+        case TypelibPlan::INT32:
+        case TypelibPlan::INT64:
+        case TypelibPlan::UINT8:
+        case TypelibPlan::UINT16:
+        case TypelibPlan::UINT32:
+        case TypelibPlan::UINT64:
+        case TypelibPlan::FLOAT:
+        case TypelibPlan::DOUBLE:
+        {
+            char buffer[TypelibPlan::NUMERIC_BUFFER_SIZE];
+            size_t len = plan.formatNumeric(data, buffer);
+            return updateScalar(static_cast<SimpleConfigValue&>(config), buffer, len);
+        }
+        case TypelibPlan::ENUM:
+        {
+            Typelib::Enum::integral_type intVal =
+                    *reinterpret_cast<const Typelib::Enum::integral_type*>(data);
+            std::unordered_map<Typelib::Enum::integral_type, std::string>::const_iterator it =
+                    plan.enumSymbols.find(intVal);
+            if(it == plan.enumSymbols.end()){
+                throw std::runtime_error("Value " + std::to_string(intVal) +
+                                         " is not valid for enum " + plan.typeName);
+            }
+            return updateScalar(static_cast<SimpleConfigValue&>(config),
+                                it->second.data(), it->second.size());
+        }
+        case TypelibPlan::STRING:
+        {
+            const std::string& content = *reinterpret_cast<const std::string*>(data);
+            return updateScalar(static_cast<SimpleConfigValue&>(config),
+                                content.data(), content.size());
+        }
+        case TypelibPlan::COMPOUND:
+        {
+            ComplexConfigValue& complex = static_cast<ComplexConfigValue&>(config);
+            const std::map<std::string, std::shared_ptr<ConfigValue> >& values =
+                    complex.getValues();
+            bool changed = false;
+            for(const TypelibPlan::Field& field : plan.fields)
+            {
+                std::map<std::string, std::shared_ptr<ConfigValue> >::const_iterator it =
+                        values.find(field.name);
+                if(it != values.end() && nodeMatches(*field.plan, *it->second)){
+                    changed |= update(*field.plan, data + field.offset, *it->second);
+                }else{
+                    std::shared_ptr<ConfigValue> convV = convert(*field.plan, data + field.offset);
+                    convV->setName(field.name);
+                    complex.setValue(field.name, convV);
+                    changed = true;
+                }
+            }
+            return changed;
+        }
+        case TypelibPlan::ARRAY:
+        {
+            ArrayConfigValue& array = static_cast<ArrayConfigValue&>(config);
+            bool changed = array.getValues().size() != plan.dimension;
+            array.truncate(plan.dimension);
+            for(size_t i = 0; i < plan.dimension; i++)
+            {
+                changed |= updateElement(*plan.element, data + i * plan.elementSize,
+                                         array, i);
+            }
+            return changed;
+        }
+        case TypelibPlan::CONTAINER:
+        {
+            const Typelib::Container& cont = *plan.container;
+            void* ptr = const_cast<uint8_t*>(data);
+            const size_t size = cont.getElementCount(ptr);
+
+            ArrayConfigValue& array = static_cast<ArrayConfigValue&>(config);
+            bool changed = array.getValues().size() != size;
+            array.truncate(size);
+            array.reserve(size);
+            for(size_t i = 0; i < size; i++)
+            {
+                Typelib::Value elem = cont.getElement(ptr, i);
+                changed |= updateElement(*plan.element,
+                                         static_cast<const uint8_t*>(elem.getData()),
+                                         array, i);
+            }
+            return changed;
+        }
+        case TypelibPlan::UNSUPPORTED:
+            if(plan.type->getCategory() == Typelib::Type::Numeric){
+                throw std::runtime_error("got numeric " + plan.typeName +
+                                         " of unexpected size " + std::to_string(plan.size));
+            }
             break;
-        case Typelib::Type::Compound:
-            return getFromCompound(value);
+    }
+    return false;
+}
+
+void emit(const TypelibPlan& plan, const uint8_t* data, YAML::Emitter& out)
+{
+    switch(plan.kind)
+    {
+        case TypelibPlan::INT8:
+        case TypelibPlan::INT16:
+        case TypelibPlan::INT32:
+        case TypelibPlan::INT64:
+        case TypelibPlan::UINT8:
+        case TypelibPlan::UINT16:
+        case TypelibPlan::UINT32:
+        case TypelibPlan::UINT64:
+        case TypelibPlan::FLOAT:
+        case TypelibPlan::DOUBLE:
+        {
+            char buffer[TypelibPlan::NUMERIC_BUFFER_SIZE];
+            size_t len = plan.formatNumeric(data, buffer);
+            out << std::string(buffer, len);
             break;
-        case Typelib::Type::Container:
-            return getFromContainer(value);
+        }
+        case TypelibPlan::ENUM:
+        {
+            Typelib::Enum::integral_type intVal =
+                    *reinterpret_cast<const Typelib::Enum::integral_type*>(data);
+            std::unordered_map<Typelib::Enum::integral_type, std::string>::const_iterator it =
+                    plan.enumSymbols.find(intVal);
+            if(it == plan.enumSymbols.end()){
+                throw std::runtime_error("Value " + std::to_string(intVal) +
+                                         " is not valid for enum " + plan.typeName);
+            }
+            out << it->second;
             break;
-        case Typelib::Type::Enum:
-            return getFromEnum(value);
+        }
+        case TypelibPlan::STRING:
+            out << *reinterpret_cast<const std::string*>(data);
             break;
-        case Typelib::Type::NullType:
+        case TypelibPlan::COMPOUND:
+            out << YAML::BeginMap;
+            for(const TypelibPlan::Field& field : plan.fields)
+            {
+                out << YAML::Key << field.name << YAML::Value;
+                emit(*field.plan, data + field.offset, out);
+            }
+            out << YAML::EndMap;
             break;
-        case Typelib::Type::Numeric:
-            return getFromNumeric(value);
+        case TypelibPlan::ARRAY:
+            //Numeric arrays are written on one line to keep large dumps compact
+            if(plan.element->isNumeric()){
+                out << YAML::Flow;
+            }
+            out << YAML::BeginSeq;
+            for(size_t i = 0; i < plan.dimension; i++)
+            {
+                emit(*plan.element, data + i * plan.elementSize, out);
+            }
+            out << YAML::EndSeq;
             break;
-        case Typelib::Type::Opaque:
+        case TypelibPlan::CONTAINER:
+        {
+            const Typelib::Container& cont = *plan.container;
+            void* ptr = const_cast<uint8_t*>(data);
+            const size_t size = cont.getElementCount(ptr);
+            if(plan.element->isNumeric()){
+                out << YAML::Flow;
+            }
+            out << YAML::BeginSeq;
+            for(size_t i = 0; i < size; i++)
+            {
+                Typelib::Value elem = cont.getElement(ptr, i);
+                emit(*plan.element, static_cast<const uint8_t*>(elem.getData()), out);
+            }
+            out << YAML::EndSeq;
             break;
-        case Typelib::Type::Pointer:
+        }
+        case TypelibPlan::UNSUPPORTED:
+            if(plan.type->getCategory() == Typelib::Type::Numeric){
+                throw std::runtime_error("got numeric " + plan.typeName +
+                                         " of unexpected size " + std::to_string(plan.size));
+            }
+            out << "Nothing";
             break;
-        default:
-            throw std::runtime_error("Got Unsupported Category");
+    }
+}
+}
 
+TypelibConfiguration::TypelibConfiguration()
+{
+}
+
+TypelibConfiguration::TypelibConfiguration(const Typelib::Registry &registry) :
+    planCache(std::make_shared<TypelibPlanCache>(registry))
+{
+}
+
+std::shared_ptr<const TypelibPlan> TypelibConfiguration::getPlan(const Typelib::Type &type)
+{
+    if(planCache){
+        return planCache->get(type);
     }
-    
-    std::shared_ptr<SimpleConfigValue> config(new SimpleConfigValue("Nothing"));
-    config->setName("Unsupported");
-    
-    return config;    
+    return TypelibPlan::compile(type);
+}
+
+std::shared_ptr< ConfigValue > TypelibConfiguration::getFromValue(Typelib::Value& value)
+{
+    std::shared_ptr<const TypelibPlan> compiled = getPlan(value.getType());
+    const TypelibPlan& plan = *compiled;
+    return convert(plan, static_cast<const uint8_t*>(value.getData()));
+}
+
+void TypelibConfiguration::writeYaml(Typelib::Value& value, YAML::Emitter& out)
+{
+    std::shared_ptr<const TypelibPlan> compiled = getPlan(value.getType());
+    const TypelibPlan& plan = *compiled;
+    emit(plan, static_cast<const uint8_t*>(value.getData()), out);
+    if(!out.good()){
+        throw std::runtime_error("Error writing YAML for " + plan.typeName + ": " +
+                                 out.GetLastError());
+    }
+}
+
+void TypelibConfiguration::writeYaml(Typelib::Value& value, std::ostream& stream)
+{
+    YAML::Emitter out(stream);
+    writeYaml(value, out);
+}
+
+bool TypelibConfiguration::updateFromValue(Typelib::Value& value, ConfigValue& config)
+{
+    std::shared_ptr<const TypelibPlan> compiled = getPlan(value.getType());
+    const TypelibPlan& plan = *compiled;
+    if(!nodeMatches(plan, config)){
+        throw std::runtime_error("Cannot update configuration value of type " +
+                                 config.getCxxTypeName() + " from " + plan.typeName);
+    }
+    return update(plan, static_cast<const uint8_t*>(value.getData()), config);
 }
 
+namespace {
+
 template <class T>
-std::string getValue(const Typelib::Value& value)
+void applyNumber(const std::string& s, void* data, const ConfigPath* path)
 {
-    T *val = static_cast<T *>(value.getData());
-    return  boost::lexical_cast<std::string>(*val);
+    parseConfigNumber(s, *static_cast<T*>(data), path);
 }
 
-std::shared_ptr< ConfigValue > TypelibConfiguration::getFromNumeric(Typelib::Value& value)
+void apply(const TypelibPlan& plan, const ConfigValue& config, uint8_t* data,
+           const ConfigPath* path);
+
+void applyField(const TypelibPlan& plan, const std::string& name,
+                const ConfigValue& config, uint8_t* data, const ConfigPath* path)
 {
-    const Typelib::Numeric &numeric(static_cast<const Typelib::Numeric &>(value.getType()));
-    
-    std::string valueS;
-    
-    switch(numeric.getNumericCategory())
+    ConfigPath fieldPath = {path, &name, 0};
+    std::unordered_map<std::string, size_t>::const_iterator idx =
+            plan.fieldIndex.find(name);
+    if(idx == plan.fieldIndex.end()){
+        throwConfigError(&fieldPath, "type " + plan.typeName + " has no such field");
+    }
+    const TypelibPlan::Field& field = plan.fields[idx->second];
+    apply(*field.plan, config, data + field.offset, &fieldPath);
+}
+
+void apply(const TypelibPlan& plan, const ConfigValue& config, uint8_t* data,
+           const ConfigPath* path)
+{
+    switch(plan.kind)
     {
-        case Typelib::Numeric::Float:
-            if(numeric.getSize() == sizeof(float))
-            {
-                valueS = getValue<float>(value);               
+        case TypelibPlan::INT8:
+            applyNumber<int8_t>(getConfigScalar(config, plan.typeName, path), data, path);
+            break;
+        case TypelibPlan::INT16:
+            applyNumber<int16_t>(getConfigScalar(config, plan.typeName, path), data, path);
+            break;
+        case TypelibPlan::INT32:
+            applyNumber<int32_t>(getConfigScalar(config, plan.typeName, path), data, path);
+            break;
+        case TypelibPlan::INT64:
+            applyNumber<int64_t>(getConfigScalar(config, plan.typeName, path), data, path);
+            break;
+        case TypelibPlan::UINT8:
+            applyNumber<uint8_t>(getConfigScalar(config, plan.typeName, path), data, path);
+            break;
+        case TypelibPlan::UINT16:
+            applyNumber<uint16_t>(getConfigScalar(config, plan.typeName, path), data, path);
+            break;
+        case TypelibPlan::UINT32:
+            applyNumber<uint32_t>(getConfigScalar(config, plan.typeName, path), data, path);
+            break;
+        case TypelibPlan::UINT64:
+            applyNumber<uint64_t>(getConfigScalar(config, plan.typeName, path), data, path);
+            break;
+        case TypelibPlan::FLOAT:
+            applyNumber<float>(getConfigScalar(config, plan.typeName, path), data, path);
+            break;
+        case TypelibPlan::DOUBLE:
+            applyNumber<double>(getConfigScalar(config, plan.typeName, path), data, path);
+            break;
+        case TypelibPlan::ENUM:
+        {
+            const std::string& s = getConfigScalar(config, plan.typeName, path);
+            //Symbols may be written as Ruby symbols, i.e. ':VALUE'
+            std::unordered_map<std::string, Typelib::Enum::integral_type>::const_iterator it =
+                    plan.enumValues.find(!s.empty() && s[0] == ':' ? s.substr(1) : s);
+            if(it == plan.enumValues.end()){
+                throwConfigError(path, "'" + s + "' is not a symbol of enum " + plan.typeName);
             }
-            else
-            {
-                valueS = getValue<double>(value);               
+            *reinterpret_cast<Typelib::Enum::integral_type*>(data) = it->second;
+            break;
+        }
+        case TypelibPlan::STRING:
+            *reinterpret_cast<std::string*>(data) = getConfigScalar(config, plan.typeName, path);
+            break;
+        case TypelibPlan::COMPOUND:
+        {
+            if(config.getType() != ConfigValue::COMPLEX){
+                throwConfigError(path, "expected a map for type " + plan.typeName);
+            }
+            const ComplexConfigValue& complex = static_cast<const ComplexConfigValue&>(config);
+            for(const auto& it : complex.getValues()){
+                applyField(plan, it.first, *it.second, data, path);
             }
             break;
-        case Typelib::Numeric::SInt:
-            switch(numeric.getSize())
+        }
+        case TypelibPlan::ARRAY:
+        {
+            const std::vector<std::shared_ptr<ConfigValue> >& elements =
+                    getConfigList(config, plan.typeName, path);
+            if(elements.size() > plan.dimension){
+                throwConfigError(path, "got " + std::to_string(elements.size()) +
+                     " elements for " + plan.typeName);
+            }
+            for(size_t i = 0; i < elements.size(); i++)
             {
-                case sizeof(int8_t):
-                    valueS = getValue<int8_t>(value);               
-                    break;
-                case sizeof(int16_t):
-                    valueS = getValue<int16_t>(value);               
-                    break;
-                case sizeof(int32_t):
-                    valueS = getValue<int32_t>(value);               
-                    break;
-                case sizeof(int64_t):
-                    valueS = getValue<int64_t>(value);               
-                    break;
-                default:
-                    std::cout << "Error, got integer of unexpected size " << numeric.getSize() << std::endl;
-                    throw std::runtime_error("got integer of unexpected size " + numeric.getSize());
-                    break;
+                ConfigPath elementPath = {path, nullptr, i};
+                apply(*plan.element, *elements[i], data + i * plan.elementSize,
+                      &elementPath);
             }
             break;
-        case Typelib::Numeric::UInt:
+        }
+        case TypelibPlan::CONTAINER:
         {
-            switch(numeric.getSize())
+            const std::vector<std::shared_ptr<ConfigValue> >& elements =
+                    getConfigList(config, plan.typeName, path);
+            const Typelib::Container& cont = *plan.container;
+
+            //Reuse the existing elements if the size does not change
+            if(cont.isRandomAccess() && cont.getElementCount(data) == elements.size())
             {
-                case sizeof(uint8_t):
-                    valueS = getValue<uint8_t>(value);               
-                    break;
-                case sizeof(uint16_t):
-                    valueS = getValue<uint16_t>(value);               
-                    break;
-                case sizeof(uint32_t):
-                    valueS = getValue<uint32_t>(value);               
-                    break;
-                case sizeof(uint64_t):
-                    valueS = getValue<uint64_t>(value);               
-                    break;
-                default:
-                    std::cout << "Error, got integer of unexpected size " << numeric.getSize() << std::endl;
-                    throw std::runtime_error("got integer of unexpected size " + numeric.getSize());
-                    break;
+                for(size_t i = 0; i < elements.size(); i++)
+                {
+                    ConfigPath elementPath = {path, nullptr, i};
+                    Typelib::Value elem = cont.getElement(data, i);
+                    apply(*plan.element, *elements[i],
+                          static_cast<uint8_t*>(elem.getData()), &elementPath);
+                }
+                break;
+            }
+
+            cont.clear(data);
+            std::vector<uint8_t> buffer(plan.elementSize);
+            Typelib::Value elem(buffer.data(), *plan.element->type);
+            for(size_t i = 0; i < elements.size(); i++)
+            {
+                ConfigPath elementPath = {path, nullptr, i};
+                Typelib::init(elem);
+                Typelib::zero(elem);
+                try{
+                    apply(*plan.element, *elements[i], buffer.data(), &elementPath);
+                    cont.push(data, elem);
+                }catch(...){
+                    Typelib::destroy(elem);
+                    throw;
+                }
+                Typelib::destroy(elem);
             }
-        }
             break;
-        case Typelib::Numeric::NumberOfValidCategories:
-            throw std::runtime_error("Internal Error: Got invalid Category");
+        }
+        case TypelibPlan::UNSUPPORTED:
+            throwConfigError(path, "type " + plan.typeName + " is not supported");
             break;
     }
-    
-    std::shared_ptr<SimpleConfigValue> config(new SimpleConfigValue(valueS));
-    
-    config->setCxxTypeName(numeric.getName());
-
-    return config;
+}
 }
 
-std::shared_ptr< ConfigValue > TypelibConfiguration::getFromContainer(Typelib::Value& value)
+namespace {
+
+//Collects the differences found by compare. Without a list, or if only the
+//first difference is requested, the comparison stops at the first one.
+struct Differences
 {
-    const Typelib::Container &cont = static_cast<const Typelib::Container &>(value.getType());
-    const size_t size = cont.getElementCount(value.getData());
-    
-    if(cont.kind() == "/std/string")
+    std::vector<std::string>* list;
+    bool all;
+    bool equal;
+
+    //Returns true if the comparison has to go on
+    bool add(const ConfigPath* path, const std::string& configured,
+             const std::string& current)
     {
-        const std::string *content = static_cast<const std::string *>(value.getData());
+        equal = false;
+        if(!list){
+            return false;
+        }
+        std::string where = ConfigPath::toString(path);
+        list->push_back((where.empty() ? std::string() : where + ": ") +
+                        "configured " + configured + ", value is " + current);
+        return all;
+    }
+};
 
-        std::shared_ptr<SimpleConfigValue> config(new SimpleConfigValue(*content));
-        config->setCxxTypeName(value.getType().getName());
-        return config;
+std::string formatCurrent(const TypelibPlan& plan, const uint8_t* data)
+{
+    if(plan.isNumeric()){
+        char buffer[TypelibPlan::NUMERIC_BUFFER_SIZE];
+        return std::string(buffer, plan.formatNumeric(data, buffer));
+    }else if(plan.kind == TypelibPlan::ENUM){
+        Typelib::Enum::integral_type intVal =
+                *reinterpret_cast<const Typelib::Enum::integral_type*>(data);
+        std::unordered_map<Typelib::Enum::integral_type, std::string>::const_iterator it =
+                plan.enumSymbols.find(intVal);
+        return it == plan.enumSymbols.end() ? std::to_string(intVal) : it->second;
     }
-    
-    //std::vector
-    std::shared_ptr<ArrayConfigValue> array(new ArrayConfigValue());
-    array->setCxxTypeName(value.getType().getName());
-    for(size_t i = 0; i < size; i++)
+    return "'" + *reinterpret_cast<const std::string*>(data) + "'";
+}
+
+//Parses the configured scalar the same way apply does and compares the
+//result with the current value, so 1 and 1.0 are equal
+template <class T>
+bool scalarMatches(void (*parse)(const std::string&, void*, const ConfigPath*),
+                   const std::string& s, const uint8_t* data, const ConfigPath* path)
+{
+    T configured;
+    parse(s, &configured, path);
+    T current = *reinterpret_cast<const T*>(data);
+    //NaN never compares equal, but applying it would not change the value
+    return configured == current || (configured != configured && current != current);
+}
+
+bool numericMatches(const TypelibPlan& plan, const std::string& s, const uint8_t* data,
+                    const ConfigPath* path)
+{
+    switch(plan.kind)
     {
-        Typelib::Value elem = cont.getElement(value.getData(), i);
-        array->addValue(getFromValue(elem));
+        case TypelibPlan::INT8: return scalarMatches<int8_t>(applyNumber<int8_t>, s, data, path);
+        case TypelibPlan::INT16: return scalarMatches<int16_t>(applyNumber<int16_t>, s, data, path);
+        case TypelibPlan::INT32: return scalarMatches<int32_t>(applyNumber<int32_t>, s, data, path);
+        case TypelibPlan::INT64: return scalarMatches<int64_t>(applyNumber<int64_t>, s, data, path);
+        case TypelibPlan::UINT8: return scalarMatches<uint8_t>(applyNumber<uint8_t>, s, data, path);
+        case TypelibPlan::UINT16: return scalarMatches<uint16_t>(applyNumber<uint16_t>, s, data, path);
+        case TypelibPlan::UINT32: return scalarMatches<uint32_t>(applyNumber<uint32_t>, s, data, path);
+        case TypelibPlan::UINT64: return scalarMatches<uint64_t>(applyNumber<uint64_t>, s, data, path);
+        case TypelibPlan::FLOAT: return scalarMatches<float>(applyNumber<float>, s, data, path);
+        case TypelibPlan::DOUBLE: return scalarMatches<double>(applyNumber<double>, s, data, path);
+        default:
+            throw std::runtime_error("Internal Error: " + plan.typeName + " is not numeric");
     }
+}
 
-    return array;
+bool compare(const TypelibPlan& plan, const ConfigValue& config, const uint8_t* data,
+             const ConfigPath* path, Differences& diff);
+
+bool compareField(const TypelibPlan& plan, const std::string& name,
+                  const ConfigValue& config, const uint8_t* data,
+                  const ConfigPath* path, Differences& diff)
+{
+    ConfigPath fieldPath = {path, &name, 0};
+    std::unordered_map<std::string, size_t>::const_iterator idx =
+            plan.fieldIndex.find(name);
+    if(idx == plan.fieldIndex.end()){
+        throwConfigError(&fieldPath, "type " + plan.typeName + " has no such field");
+    }
+    const TypelibPlan::Field& field = plan.fields[idx->second];
+    return compare(*field.plan, config, data + field.offset, &fieldPath, diff);
 }
 
-std::shared_ptr< ConfigValue > TypelibConfiguration::getFromCompound(Typelib::Value& value)
+//Returns true if the comparison has to go on
+bool compare(const TypelibPlan& plan, const ConfigValue& config, const uint8_t* data,
+             const ConfigPath* path, Differences& diff)
 {
-    std::shared_ptr<ComplexConfigValue> config(new ComplexConfigValue());
-    
-    config->setCxxTypeName(value.getType().getName());
-    
-    const Typelib::Compound &comp = static_cast<const Typelib::Compound &>(value.getType());
-     
-    uint8_t *data = static_cast<uint8_t *>( value.getData());
-    
-    for(const Typelib::Field &field: comp.getFields())
+    switch(plan.kind)
     {
-        Typelib::Value fieldV(data + field.getOffset(), field.getType());
-        std::shared_ptr< ConfigValue > convV = getFromValue(fieldV);
-        convV->setName(field.getName());
-        config->addValue(field.getName(), convV);
+        case TypelibPlan::INT8:
+        case TypelibPlan::INT16:
+        case TypelibPlan::INT32:
+        case TypelibPlan::INT64:
+        case TypelibPlan::UINT8:
+        case TypelibPlan::UINT16:
+        case TypelibPlan::UINT32:
+        case TypelibPlan::UINT64:
+        case TypelibPlan::FLOAT:
+        case TypelibPlan::DOUBLE:
+        {
+            const std::string& s = getConfigScalar(config, plan.typeName, path);
+            if(!numericMatches(plan, s, data, path)){
+                return diff.add(path, s, formatCurrent(plan, data));
+            }
+            return true;
+        }
+        case TypelibPlan::ENUM:
+        {
+            const std::string& s = getConfigScalar(config, plan.typeName, path);
+            std::unordered_map<std::string, Typelib::Enum::integral_type>::const_iterator it =
+                    plan.enumValues.find(!s.empty() && s[0] == ':' ? s.substr(1) : s);
+            if(it == plan.enumValues.end()){
+                throwConfigError(path, "'" + s + "' is not a symbol of enum " + plan.typeName);
+            }
+            if(it->second != *reinterpret_cast<const Typelib::Enum::integral_type*>(data)){
+                return diff.add(path, s, formatCurrent(plan, data));
+            }
+            return true;
+        }
+        case TypelibPlan::STRING:
+        {
+            const std::string& s = getConfigScalar(config, plan.typeName, path);
+            if(s != *reinterpret_cast<const std::string*>(data)){
+                return diff.add(path, "'" + s + "'", formatCurrent(plan, data));
+            }
+            return true;
+        }
+        case TypelibPlan::COMPOUND:
+        {
+            if(config.getType() != ConfigValue::COMPLEX){
+                throwConfigError(path, "expected a map for type " + plan.typeName);
+            }
+            const ComplexConfigValue& complex = static_cast<const ComplexConfigValue&>(config);
+            for(const auto& it : complex.getValues()){
+                if(!compareField(plan, it.first, *it.second, data, path, diff)){
+                    return false;
+                }
+            }
+            return true;
+        }
+        case TypelibPlan::ARRAY:
+        {
+            const std::vector<std::shared_ptr<ConfigValue> >& elements =
+                    getConfigList(config, plan.typeName, path);
+            if(elements.size() > plan.dimension){
+                throwConfigError(path, "got " + std::to_string(elements.size()) +
+                     " elements for " + plan.typeName);
+            }
+            for(size_t i = 0; i < elements.size(); i++)
+            {
+                ConfigPath elementPath = {path, nullptr, i};
+                if(!compare(*plan.element, *elements[i], data + i * plan.elementSize,
+                            &elementPath, diff))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+        case TypelibPlan::CONTAINER:
+        {
+            const std::vector<std::shared_ptr<ConfigValue> >& elements =
+                    getConfigList(config, plan.typeName, path);
+            const Typelib::Container& cont = *plan.container;
+            void* ptr = const_cast<uint8_t*>(data);
+            const size_t size = cont.getElementCount(ptr);
+            if(size != elements.size()){
+                return diff.add(path, std::to_string(elements.size()) + " elements",
+                                std::to_string(size) + " elements");
+            }
+            for(size_t i = 0; i < size; i++)
+            {
+                ConfigPath elementPath = {path, nullptr, i};
+                Typelib::Value elem = cont.getElement(ptr, i);
+                if(!compare(*plan.element, *elements[i],
+                            static_cast<const uint8_t*>(elem.getData()), &elementPath, diff))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+        case TypelibPlan::UNSUPPORTED:
+            throwConfigError(path, "type " + plan.typeName + " is not supported");
+            break;
     }
-    
-    return config;
+    return true;
+}
 }
 
-std::shared_ptr< ConfigValue > TypelibConfiguration::getFromArray(Typelib::Value& value)
+bool TypelibConfiguration::matchesValue(const ConfigValue& config, Typelib::Value& value,
+                                        std::vector<std::string>* differences,
+                                        bool allDifferences)
 {
-    std::shared_ptr<ArrayConfigValue> config(new ArrayConfigValue());
+    std::shared_ptr<const TypelibPlan> compiled = getPlan(value.getType());
+    const TypelibPlan& plan = *compiled;
+    Differences diff = {differences, allDifferences, true};
+    compare(plan, config, static_cast<const uint8_t*>(value.getData()), nullptr, diff);
+    return diff.equal;
+}
 
-    const Typelib::Array &array = static_cast<const Typelib::Array &>(value.getType());
-    config->setCxxTypeName(array.getName());
-    
-    void *data = value.getData();
-    
-    const Typelib::Type &indirect(array.getIndirection());
-    
-    for(size_t i = 0; i < array.getDimension(); i++)
+bool TypelibConfiguration::matchesValue(const Configuration& config, Typelib::Value& value,
+                                        std::vector<std::string>* differences,
+                                        bool allDifferences)
+{
+    std::shared_ptr<const TypelibPlan> compiled = getPlan(value.getType());
+    const TypelibPlan& plan = *compiled;
+    if(plan.kind != TypelibPlan::COMPOUND){
+        throw std::runtime_error("Cannot compare configuration " + config.getName() +
+                                 " to non-compound type " + plan.typeName);
+    }
+    Differences diff = {differences, allDifferences, true};
+    const uint8_t* data = static_cast<const uint8_t*>(value.getData());
+    for(const auto& it : config.getValues()){
+        if(!compareField(plan, it.first, *it.second, data, nullptr, diff)){
+            break;
+        }
+    }
+    return diff.equal;
+}
+
+namespace {
+
+void check(const TypelibPlan& plan, const ConfigValue& config, const ConfigPath* path,
+           std::vector<std::string>& errors);
+
+//Parses a scalar into scratch memory to find malformed and out-of-range values
+template <class T>
+void checkScalar(void (*parse)(const std::string&, void*, const ConfigPath*),
+                 const std::string& s, const ConfigPath* path)
+{
+    T scratch;
+    parse(s, &scratch, path);
+}
+
+void checkField(const TypelibPlan& plan, const std::string& name, const ConfigValue& config,
+                const ConfigPath* path, std::vector<std::string>& errors)
+{
+    ConfigPath fieldPath = {path, &name, 0};
+    std::unordered_map<std::string, size_t>::const_iterator idx =
+            plan.fieldIndex.find(name);
+    if(idx == plan.fieldIndex.end()){
+        try{
+            throwConfigError(&fieldPath, "type " + plan.typeName + " has no such field");
+        }catch(const std::runtime_error& e){
+            errors.push_back(e.what());
+        }
+        return;
+    }
+    check(*plan.fields[idx->second].plan, config, &fieldPath, errors);
+}
+
+void checkElements(const TypelibPlan& plan, const ConfigValue& config, const ConfigPath* path,
+                   std::vector<std::string>& errors)
+{
+    const std::vector<std::shared_ptr<ConfigValue> >& elements =
+            getConfigList(config, plan.typeName, path);
+    if(plan.kind == TypelibPlan::ARRAY && elements.size() > plan.dimension){
+        throwConfigError(path, "got " + std::to_string(elements.size()) +
+             " elements for " + plan.typeName);
+    }
+    for(size_t i = 0; i < elements.size(); i++)
     {
-        Typelib::Value arrayV(static_cast<uint8_t *>(data) + i * indirect.getSize(), indirect);
-        config->addValue(getFromValue(arrayV));
+        ConfigPath elementPath = {path, nullptr, i};
+        check(*plan.element, *elements[i], &elementPath, errors);
     }
-    
-    return config;
 }
 
-std::shared_ptr< ConfigValue > TypelibConfiguration::getFromEnum(Typelib::Value& value)
+//Reports every error applyToValue could throw, without touching typed memory
+void check(const TypelibPlan& plan, const ConfigValue& config, const ConfigPath* path,
+           std::vector<std::string>& errors)
 {
-    const Typelib::Enum &enumT = static_cast<const Typelib::Enum &>(value.getType());
-    
-    Typelib::Enum::integral_type *intVal = (static_cast<Typelib::Enum::integral_type *>(value.getData()));
-    
-    std::shared_ptr<SimpleConfigValue> config(new SimpleConfigValue(enumT.get(*intVal)));
-    config->setCxxTypeName(enumT.getName());
-    
-    return config;
+    try{
+        switch(plan.kind)
+        {
+            case TypelibPlan::INT8:
+                checkScalar<int8_t>(applyNumber<int8_t>, getConfigScalar(config, plan.typeName, path), path);
+                break;
+            case TypelibPlan::INT16:
+                checkScalar<int16_t>(applyNumber<int16_t>, getConfigScalar(config, plan.typeName, path), path);
+                break;
+            case TypelibPlan::INT32:
+                checkScalar<int32_t>(applyNumber<int32_t>, getConfigScalar(config, plan.typeName, path), path);
+                break;
+            case TypelibPlan::INT64:
+                checkScalar<int64_t>(applyNumber<int64_t>, getConfigScalar(config, plan.typeName, path), path);
+                break;
+            case TypelibPlan::UINT8:
+                checkScalar<uint8_t>(applyNumber<uint8_t>, getConfigScalar(config, plan.typeName, path), path);
+                break;
+            case TypelibPlan::UINT16:
+                checkScalar<uint16_t>(applyNumber<uint16_t>, getConfigScalar(config, plan.typeName, path), path);
+                break;
+            case TypelibPlan::UINT32:
+                checkScalar<uint32_t>(applyNumber<uint32_t>, getConfigScalar(config, plan.typeName, path), path);
+                break;
+            case TypelibPlan::UINT64:
+                checkScalar<uint64_t>(applyNumber<uint64_t>, getConfigScalar(config, plan.typeName, path), path);
+                break;
+            case TypelibPlan::FLOAT:
+                checkScalar<float>(applyNumber<float>, getConfigScalar(config, plan.typeName, path), path);
+                break;
+            case TypelibPlan::DOUBLE:
+                checkScalar<double>(applyNumber<double>, getConfigScalar(config, plan.typeName, path), path);
+                break;
+            case TypelibPlan::ENUM:
+            {
+                const std::string& s = getConfigScalar(config, plan.typeName, path);
+                if(!plan.enumValues.count(!s.empty() && s[0] == ':' ? s.substr(1) : s)){
+                    throwConfigError(path, "'" + s + "' is not a symbol of enum " + plan.typeName);
+                }
+                break;
+            }
+            case TypelibPlan::STRING:
+                getConfigScalar(config, plan.typeName, path);
+                break;
+            case TypelibPlan::COMPOUND:
+            {
+                if(config.getType() != ConfigValue::COMPLEX){
+                    throwConfigError(path, "expected a map for type " + plan.typeName);
+                }
+                const ComplexConfigValue& complex = static_cast<const ComplexConfigValue&>(config);
+                for(const auto& it : complex.getValues()){
+                    checkField(plan, it.first, *it.second, path, errors);
+                }
+                break;
+            }
+            case TypelibPlan::ARRAY:
+            case TypelibPlan::CONTAINER:
+                checkElements(plan, config, path, errors);
+                break;
+            case TypelibPlan::UNSUPPORTED:
+                throwConfigError(path, "type " + plan.typeName + " is not supported");
+                break;
+        }
+    }catch(const std::runtime_error& e){
+        errors.push_back(e.what());
+    }
+}
+}
+
+void TypelibConfiguration::validate(const ConfigValue& config, const Typelib::Type& type,
+                                    std::vector<std::string>& errors)
+{
+    check(*getPlan(type), config, nullptr, errors);
+}
+
+void TypelibConfiguration::applyToValue(const ConfigValue& config, Typelib::Value& value)
+{
+    std::shared_ptr<const TypelibPlan> compiled = getPlan(value.getType());
+    const TypelibPlan& plan = *compiled;
+    apply(plan, config, static_cast<uint8_t*>(value.getData()), nullptr);
+}
+
+void TypelibConfiguration::applyToValue(const Configuration& config, Typelib::Value& value)
+{
+    std::shared_ptr<const TypelibPlan> compiled = getPlan(value.getType());
+    const TypelibPlan& plan = *compiled;
+    if(plan.kind != TypelibPlan::COMPOUND){
+        throw std::runtime_error("Cannot apply configuration " + config.getName() +
+                                 " to non-compound type " + plan.typeName);
+    }
+    uint8_t* data = static_cast<uint8_t*>(value.getData());
+    for(const auto& it : config.getValues()){
+        applyField(plan, it.first, *it.second, data, nullptr);
+    }
 }
 }
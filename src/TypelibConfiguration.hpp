@@ -2,20 +2,101 @@
 
 #include <typelib/value.hh>
 #include "Configuration.hpp"
+#include <iosfwd>
+
+namespace Typelib
+{
+class Registry;
+}
 
 namespace libConfig {
+struct TypelibPlan;
+class TypelibPlanCache;
+
 class TypelibConfiguration
 {
-    std::shared_ptr< libConfig::ConfigValue > getFromArray(Typelib::Value& value);
-    std::shared_ptr< libConfig::ConfigValue > getFromEnum(Typelib::Value& value);
-    std::shared_ptr< libConfig::ConfigValue > getFromCompound(Typelib::Value& value);
-    std::shared_ptr< libConfig::ConfigValue > getFromContainer(Typelib::Value& value);
-    std::shared_ptr< libConfig::ConfigValue > getFromNumeric(Typelib::Value& value);
-
 public:
+    //Compiles the TypelibPlan of the converted type on each call
+    TypelibConfiguration();
+    /**
+     * @brief Caches the TypelibPlans of the types of registry
+     * Other types are compiled on each call. The registry has to outlive
+     * this object and its copies, which share the cache.
+     */
+    explicit TypelibConfiguration(const Typelib::Registry& registry);
+
+    /**
+     * @brief Converts typed memory into a ConfigValue tree
+     * The conversion uses the TypelibPlan of the value's type.
+     * Numbers are written in the shortest form that reads back to the same
+     * value.
+     */
     std::shared_ptr< libConfig::ConfigValue > getFromValue(Typelib::Value& value);
+
+    /**
+     * @brief Refreshes a ConfigValue tree created by getFromValue from the
+     * current content of the value
+     * Existing nodes are reused: scalars are overwritten in place and
+     * arrays only grow or shrink if the container size changed. Nodes are
+     * only allocated for new elements or if the tree does not match the type.
+     * Entries of the tree that are not fields of the type are kept.
+     * @return true if anything in the tree changed
+     */
+    bool updateFromValue(Typelib::Value& value, ConfigValue& config);
+
+    /**
+     * @brief Writes typed memory as YAML without building a ConfigValue tree
+     * The output parses to the same configuration getFromValue() creates.
+     * Compound fields are written in declaration order, sequences of
+     * numbers in flow style.
+     */
+    void writeYaml(Typelib::Value& value, YAML::Emitter& out);
+    void writeYaml(Typelib::Value& value, std::ostream& out);
+
+    /**
+     * @brief Writes a configuration value into typed memory
+     * Compound fields that are not present in the configuration keep their
+     * current value. Containers are resized to the number of configured
+     * elements, arrays may be configured partially.
+     * Throws std::runtime_error naming the offending path on unknown fields,
+     * bad enum symbols, malformed or out-of-range numbers and type
+     * mismatches. The value may be partially written in that case.
+     */
+    void applyToValue(const ConfigValue& config, Typelib::Value& value);
+    //Applies the properties of a configuration to the fields of a compound
+    void applyToValue(const Configuration& config, Typelib::Value& value);
+
+    /**
+     * @brief Checks a configuration value against a type without applying it
+     * Appends one message to errors for every problem applyToValue would
+     * throw on: unknown fields, type mismatches, bad enum symbols and
+     * malformed or out-of-range numbers.
+     */
+    void validate(const ConfigValue& config, const Typelib::Type& type,
+                  std::vector<std::string>& errors);
+
+    /**
+     * @brief Checks whether applying the configuration would leave the value
+     * unchanged, without converting the value
+     * Numbers are compared after parsing, so 1 and 1.0 are equal. Fields
+     * and array elements that are not configured are not compared.
+     * Malformed configurations throw the same errors as applyToValue.
+     * @param differences: If given, receives one entry per differing path
+     * @param allDifferences: Report every difference instead of stopping at
+     *        the first one
+     */
+    bool matchesValue(const ConfigValue& config, Typelib::Value& value,
+                      std::vector<std::string>* differences = nullptr,
+                      bool allDifferences = false);
+    bool matchesValue(const Configuration& config, Typelib::Value& value,
+                      std::vector<std::string>* differences = nullptr,
+                      bool allDifferences = false);
 protected:
     void num();
+private:
+    std::shared_ptr<TypelibPlanCache> planCache;
+
+    std::shared_ptr<const TypelibPlan> getPlan(const Typelib::Type& type);
 };
 }
 
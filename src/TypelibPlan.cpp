@@ -0,0 +1,200 @@
+#include "TypelibPlan.hpp"
+#include <typelib/registry.hh>
+#include <charconv>
+#include <stdexcept>
+
+namespace libConfig {
+
+namespace
+{
+typedef std::unordered_map<const Typelib::Type*, std::unique_ptr<TypelibPlan> > PlanMap;
+
+template <class T>
+size_t format(const void* data, char* buffer)
+{
+    std::to_chars_result res = std::to_chars(
+                buffer, buffer + TypelibPlan::NUMERIC_BUFFER_SIZE,
+                *static_cast<const T*>(data));
+    return res.ptr - buffer;
+}
+
+TypelibPlan::Kind numericKind(const Typelib::Numeric& numeric)
+{
+    switch(numeric.getNumericCategory())
+    {
+        case Typelib::Numeric::Float:
+            if(numeric.getSize() == sizeof(float)){
+                return TypelibPlan::FLOAT;
+            }else if(numeric.getSize() == sizeof(double)){
+                return TypelibPlan::DOUBLE;
+            }
+            break;
+        case Typelib::Numeric::SInt:
+            switch(numeric.getSize())
+            {
+                case sizeof(int8_t): return TypelibPlan::INT8;
+                case sizeof(int16_t): return TypelibPlan::INT16;
+                case sizeof(int32_t): return TypelibPlan::INT32;
+                case sizeof(int64_t): return TypelibPlan::INT64;
+            }
+            break;
+        case Typelib::Numeric::UInt:
+            switch(numeric.getSize())
+            {
+                case sizeof(uint8_t): return TypelibPlan::UINT8;
+                case sizeof(uint16_t): return TypelibPlan::UINT16;
+                case sizeof(uint32_t): return TypelibPlan::UINT32;
+                case sizeof(uint64_t): return TypelibPlan::UINT64;
+            }
+            break;
+        default:
+            break;
+    }
+    //Integers of unexpected size are reported when a value is converted
+    return TypelibPlan::UNSUPPORTED;
+}
+
+//Compiles the plan of type into plans, which owns the plans of all nested
+//types. The plan is inserted before its children are compiled, so recursive
+//types terminate.
+const TypelibPlan& compileInto(const Typelib::Type& type, PlanMap& plans)
+{
+    PlanMap::const_iterator it = plans.find(&type);
+    if(it != plans.end()){
+        return *it->second;
+    }
+
+    TypelibPlan* plan = new TypelibPlan();
+    plans[&type].reset(plan);
+    plan->type = &type;
+    plan->typeName = type.getName();
+    plan->size = type.getSize();
+
+    switch(type.getCategory())
+    {
+        case Typelib::Type::Numeric:
+            plan->kind = numericKind(static_cast<const Typelib::Numeric&>(type));
+            break;
+        case Typelib::Type::Enum:
+        {
+            const Typelib::Enum& enumT = static_cast<const Typelib::Enum&>(type);
+            plan->kind = TypelibPlan::ENUM;
+            for(const auto& entry : enumT.values()){
+                plan->enumValues[entry.first] = entry.second;
+                plan->enumSymbols[entry.second] = entry.first;
+            }
+            break;
+        }
+        case Typelib::Type::Compound:
+        {
+            const Typelib::Compound& comp = static_cast<const Typelib::Compound&>(type);
+            plan->kind = TypelibPlan::COMPOUND;
+            for(const Typelib::Field& field : comp.getFields())
+            {
+                TypelibPlan::Field f;
+                f.name = field.getName();
+                f.offset = field.getOffset();
+                f.plan = &compileInto(field.getType(), plans);
+                plan->fieldIndex[f.name] = plan->fields.size();
+                plan->fields.push_back(f);
+            }
+            break;
+        }
+        case Typelib::Type::Array:
+        {
+            const Typelib::Array& array = static_cast<const Typelib::Array&>(type);
+            plan->kind = TypelibPlan::ARRAY;
+            plan->dimension = array.getDimension();
+            plan->elementSize = array.getIndirection().getSize();
+            plan->element = &compileInto(array.getIndirection(), plans);
+            break;
+        }
+        case Typelib::Type::Container:
+        {
+            const Typelib::Container& cont = static_cast<const Typelib::Container&>(type);
+            plan->container = &cont;
+            if(cont.kind() == "/std/string"){
+                plan->kind = TypelibPlan::STRING;
+            }else{
+                plan->kind = TypelibPlan::CONTAINER;
+                plan->elementSize = cont.getIndirection().getSize();
+                plan->element = &compileInto(cont.getIndirection(), plans);
+            }
+            break;
+        }
+        default:
+            plan->kind = TypelibPlan::UNSUPPORTED;
+            break;
+    }
+    return *plan;
+}
+}
+
+TypelibPlan::TypelibPlan() :
+    kind(UNSUPPORTED), type(nullptr), size(0), element(nullptr),
+    elementSize(0), dimension(0), container(nullptr)
+{
+}
+
+size_t TypelibPlan::formatNumeric(const void *data, char *buffer) const
+{
+    switch(kind)
+    {
+        case INT8: return format<int8_t>(data, buffer);
+        case INT16: return format<int16_t>(data, buffer);
+        case INT32: return format<int32_t>(data, buffer);
+        case INT64: return format<int64_t>(data, buffer);
+        case UINT8: return format<uint8_t>(data, buffer);
+        case UINT16: return format<uint16_t>(data, buffer);
+        case UINT32: return format<uint32_t>(data, buffer);
+        case UINT64: return format<uint64_t>(data, buffer);
+        case FLOAT: return format<float>(data, buffer);
+        case DOUBLE: return format<double>(data, buffer);
+        default:
+            throw std::runtime_error("Internal Error: " + typeName + " is not numeric");
+    }
+}
+
+std::shared_ptr<const TypelibPlan> TypelibPlan::compile(const Typelib::Type &type)
+{
+    //The returned pointer shares the ownership of the nested plans
+    std::shared_ptr<PlanMap> plans = std::make_shared<PlanMap>();
+    const TypelibPlan& plan = compileInto(type, *plans);
+    return std::shared_ptr<const TypelibPlan>(plans, &plan);
+}
+
+struct TypelibPlanCache::Plans
+{
+    PlanMap map;
+};
+
+TypelibPlanCache::TypelibPlanCache(const Typelib::Registry &registry) :
+    registry(registry), plans(std::make_shared<Plans>())
+{
+}
+
+std::shared_ptr<const TypelibPlan> TypelibPlanCache::get(const Typelib::Type &type)
+{
+    if(registry.get(type.getName()) != &type){
+        //Not owned by the registry, the type may be gone on the next call
+        return TypelibPlan::compile(type);
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    const TypelibPlan& plan = compileInto(type, plans->map);
+    return std::shared_ptr<const TypelibPlan>(plans, &plan);
+}
+
+void TypelibPlanCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    //Plans still held by callers keep the previous map alive
+    plans = std::make_shared<Plans>();
+}
+
+size_t TypelibPlanCache::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return plans->map.size();
+}
+
+}
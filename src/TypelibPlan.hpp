@@ -0,0 +1,132 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <typelib/typemodel.hh>
+
+namespace Typelib
+{
+class Registry;
+}
+
+namespace libConfig {
+
+/**
+ * @brief Conversion plan for a Typelib type
+ *
+ * A plan is compiled once per Typelib::Type and contains everything that is
+ * needed to walk typed memory: field offsets, the numeric category and size,
+ * enum symbol tables and container accessors. Converting values with a plan
+ * does not query the type model again.
+ *
+ * A plan refers to the types it was compiled from, so it must not be used
+ * after they are destroyed. Plans of the types of a registry can be cached
+ * with a TypelibPlanCache.
+ */
+struct TypelibPlan
+{
+    enum Kind {
+        INT8,
+        INT16,
+        INT32,
+        INT64,
+        UINT8,
+        UINT16,
+        UINT32,
+        UINT64,
+        FLOAT,
+        DOUBLE,
+        ENUM,
+        STRING,
+        COMPOUND,
+        ARRAY,
+        CONTAINER,
+        UNSUPPORTED,
+    };
+
+    struct Field
+    {
+        std::string name;
+        size_t offset;
+        const TypelibPlan* plan;
+    };
+
+    Kind kind;
+    const Typelib::Type* type;
+    std::string typeName;
+    size_t size;
+
+    //COMPOUND
+    std::vector<Field> fields;
+    std::unordered_map<std::string, size_t> fieldIndex;
+
+    //ARRAY and CONTAINER
+    const TypelibPlan* element;
+    size_t elementSize;
+    size_t dimension;
+    const Typelib::Container* container;
+
+    //ENUM
+    std::unordered_map<std::string, Typelib::Enum::integral_type> enumValues;
+    std::unordered_map<Typelib::Enum::integral_type, std::string> enumSymbols;
+
+    //Large enough for any number written by formatNumeric
+    static const size_t NUMERIC_BUFFER_SIZE = 32;
+
+    TypelibPlan();
+
+    bool isNumeric() const
+    {
+        return kind <= DOUBLE;
+    }
+
+    /**
+     * @brief Formats the numeric value at data into buffer, which has to
+     * hold NUMERIC_BUFFER_SIZE characters. Floating point values are written
+     * in the shortest form that reads back to the same value.
+     * @return Number of characters written, the buffer is not terminated
+     */
+    size_t formatNumeric(const void* data, char* buffer) const;
+
+    /**
+     * @brief Compiles the plan of a type and of the types it refers to
+     * The plan does not depend on a cache and is freed when the last pointer
+     * to it is released.
+     */
+    static std::shared_ptr<const TypelibPlan> compile(const Typelib::Type& type);
+};
+
+/**
+ * @brief Caches the plans of the types of one Typelib::Registry
+ * Types are identified by their name in the registry. Plans of types that
+ * are not part of the registry are compiled on each call, so a type that is
+ * destroyed can never be confused with a cached one. The registry has to
+ * outlive the cache. Thread-safe.
+ */
+class TypelibPlanCache
+{
+public:
+    explicit TypelibPlanCache(const Typelib::Registry& registry);
+
+    /**
+     * @brief Returns the plan for the given type, compiling it on first use
+     * The plan stays valid while the pointer is held, also after clear().
+     */
+    std::shared_ptr<const TypelibPlan> get(const Typelib::Type& type);
+    //Drops the cached plans, e.g. after types were added to the registry
+    void clear();
+    //Number of cached plans, including the plans of nested types
+    size_t size() const;
+
+private:
+    struct Plans;
+
+    const Typelib::Registry& registry;
+    mutable std::mutex mutex;
+    std::shared_ptr<Plans> plans;
+};
+
+}
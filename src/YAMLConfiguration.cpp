@@ -4,6 +4,7 @@
 #include <fstream>
 #include <iostream>
 #include "Bundle.hpp"
+#include "LoadMetrics.hpp"
 #include <base-logging/Logging.hpp>
 
 using namespace libConfig;
@@ -111,7 +112,7 @@ std::shared_ptr<ConfigValue> YAMLConfigParser::getConfigValue(const YAML::Node &
 	        if(s.compare(".nan")==0) {
 	            s="nan";
 	        }
-            conf.reset(new SimpleConfigValue(s));
+            conf = std::make_shared<SimpleConfigValue>(s);
             return conf;
         }
             break;
@@ -183,7 +184,9 @@ void YAMLConfigParser::displayMap(const YAML::Node &map, int level)
 
 bool YAMLConfigParser::parseAndInsert(const std::string& configName, const std::string& ymlString, std::map< std::string, Configuration >& subConfigs)
 {
+    LoadMetrics::SectionScope metrics(configName, ymlString.size());
     std::string afterInsertion = applyStringVariableInsertions(ymlString);
+    metrics.insertionDone();
 
     Configuration config(configName);
     
@@ -196,6 +199,7 @@ bool YAMLConfigParser::parseAndInsert(const std::string& configName, const std::
         LOG_ERROR_S << "YML of subconfig was :"  << std::endl << afterInsertion;
         return false;
     }
+    metrics.parsed(config);
     subConfigs.insert(std::make_pair(config.getName(), config));
     
     return true;
@@ -210,6 +214,11 @@ bool YAMLConfigParser::loadConfigFile(const std::string& pathStr, std::map<std::
         throw std::runtime_error(std::string("Error, could not find config file ") + path.c_str());
     }
 
+    LoadMetrics::FileScope metrics(pathStr);
+    if(LoadMetrics::isEnabled()){
+        metrics.setBytesRead(file_size(path));
+    }
+
     std::ifstream fin(path.c_str());
     bool st = loadConfig(fin, subConfigs);
     fin.close();
@@ -218,6 +227,9 @@ bool YAMLConfigParser::loadConfigFile(const std::string& pathStr, std::map<std::
 
 bool libConfig::YAMLConfigParser::loadConfigString(const std::string &yamlstring, std::map<std::string, libConfig::Configuration> &subConfigs)
 {
+    LoadMetrics::FileScope metrics("<string>");
+    metrics.setBytesRead(yamlstring.size());
+
     std::istringstream ss;
     ss.str(yamlstring);
     return loadConfig(ss, subConfigs);
@@ -346,7 +358,7 @@ std::string YAMLConfigParser::applyStringVariableInsertions(const std::string& v
             
             std::string file;
             try{
-                file = Bundle::getInstance().findFileByName(var);
+                file = Bundle::findInstanceFile(var);
             }
             catch (...)
             {
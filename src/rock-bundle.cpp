@@ -1,6 +1,18 @@
 #include <iostream>
 #include "Bundle.hpp"
+#include "ResolvedDeployment.hpp"
+#include <boost/filesystem.hpp>
 #include <iostream>
+#include <sstream>
+#include <cstring>
+#include <cstdint>
+#include <csignal>
+#include <functional>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
 
 void usage()
 {
@@ -25,6 +37,28 @@ MODES:
     findext (SUBDIR) [EXT] : Find all files woth the extension EXT in all
                              selected bundles. By passing SUBDIR search is
                              limited to the given sub-folder within the bundles
+    config [TASK] (SECTIONS...)
+                           : Print the merged configuration of the task model
+                             TASK for the given sections as YAML. Defaults to
+                             the section 'default'
+    resolve [DESCRIPTION] (OUTPUT)
+                           : Merge the configurations of all tasks of the
+                             deployment description file DESCRIPTION and
+                             write them into the single file OUTPUT, or print
+                             them. Only the task models of the deployment are
+                             loaded. See ResolvedDeployment.hpp for the format
+    batch                  : Initialize once, then answer one query per line
+                             of stdin (e.g. 'find1 config/bundle.yml'). Each
+                             answer starts with a line 'OK <SIZE>' or
+                             'ERROR <SIZE>', followed by SIZE bytes of output
+    serve (IDLE_TIMEOUT)   : Keep the initialized bundle in memory and answer
+                             the modes above over a Unix socket. Exits after
+                             IDLE_TIMEOUT seconds without requests, if given
+    client [MODE] ...      : Send MODE to the daemon of the current
+                             environment, run it directly if no daemon is
+                             running. 'client refresh' makes the daemon
+                             initialize the bundle again, e.g. after files
+                             were added, 'client stop' stops it
 
 A Bundles is selected by setting the ROCK_BUNDLE environment variable to the name of the bundle.
 The name of a bundle is defioned by its folder name. The folder needs to be placed within on of possibly multipe paths that can be defined in the environment varibale ROCK_BUNDLE_PATH.
@@ -48,120 +82,552 @@ std::string str(const std::vector<T> & vec, std::string sep=", ")
     return ss.str();
 }
 
-int handle_request(int argc, char** argv)
+//Initialized bundle kept by 'serve' and 'batch', requests use it instead of
+//initializing their own
+libConfig::Bundle* servedBundle = nullptr;
+
+//Returns the served bundle or initializes local, nullptr on errors. Task
+//configurations are loaded lazily, so only the requested ones are parsed.
+libConfig::Bundle* get_bundle(libConfig::Bundle& local, bool loadTaskConfigs = false)
+{
+    if(servedBundle){
+        return servedBundle;
+    }
+    local.taskConfigurations.setLazyLoading(true);
+    return local.initialize(loadTaskConfigs) ? &local : nullptr;
+}
+
+//Runs a single query. The output is written to out and err, so that the
+//daemon can send it back to the client.
+int handle_request(const std::vector<std::string>& args, std::ostream& out,
+                   std::ostream& err)
 {
-    std::string mode=argv[1];
+    const size_t argc = args.size();
+    std::string mode=args[0];
     if(mode == "info"){
-        libConfig::Bundle b;
-        if(!b.initialize(false)){
+        libConfig::Bundle local;
+        libConfig::Bundle* b = get_bundle(local);
+        if(!b){
             return EXIT_FAILURE;
         }
-        std::cout << "Active bundles: " << str(b.getActiveBundleNames()) << std::endl;
-        std::cout << "Available bundles: " << std::endl;
-        for(const libConfig::SingleBundle& sb : b.getAvailableBundles())
+        out << "Active bundles: " << str(b->getActiveBundleNames()) << std::endl;
+        out << "Available bundles: " << std::endl;
+        for(const libConfig::SingleBundle& sb : b->getAvailableBundles())
         {
-            std::cout << "  " << sb.name << " (" << sb.path << ")" << std::endl;
+            out << "  " << sb.name << " (" << sb.path << ")" << std::endl;
         }
-        std::cout << "Selected bundle: " << b.getActiveBundleName() << " (" <<  b.getActiveBundles()[0].path << ")" << std::endl;
+        out << "Selected bundle: " << b->getActiveBundleName() << " (" <<  b->getActiveBundles()[0].path << ")" << std::endl;
         return EXIT_SUCCESS;
     }
     else if(mode == "selected")
     {
-        libConfig::Bundle b;
-        if(!b.initialize(false)){
+        libConfig::Bundle local;
+        libConfig::Bundle* b = get_bundle(local);
+        if(!b){
             return EXIT_FAILURE;
         }
-        std::cout << b.getActiveBundles()[0].name << std::endl;
+        out << b->getActiveBundles()[0].name << std::endl;
         return EXIT_SUCCESS;
     }
     else if(mode == "selectedpath")
     {
-        libConfig::Bundle b;
-        if(!b.initialize(false)){
+        libConfig::Bundle local;
+        libConfig::Bundle* b = get_bundle(local);
+        if(!b){
             return EXIT_FAILURE;
         }
-        std::cout << b.getActiveBundles()[0].path << std::endl;
+        out << b->getActiveBundles()[0].path << std::endl;
         return EXIT_SUCCESS;
     }
     else if(mode == "active")
     {
-        libConfig::Bundle b;
-        if(!b.initialize(false)){
+        libConfig::Bundle local;
+        libConfig::Bundle* b = get_bundle(local);
+        if(!b){
             return EXIT_FAILURE;
         }
-        for (const libConfig::SingleBundle& sb : b.getActiveBundles()){
-            std::cout << sb.name << std::endl;
+        for (const libConfig::SingleBundle& sb : b->getActiveBundles()){
+            out << sb.name << std::endl;
         }
         return EXIT_SUCCESS;
     }
     else if(mode == "find")
     {
-        if(argc < 3){
-            std::cerr << "No filename to search for was given" << std::endl;
+        if(argc < 2){
+            err << "No filename to search for was given" << std::endl;
             return EXIT_FAILURE;
         }
-        libConfig::Bundle b;
-        if(!b.initialize(false)){
+        libConfig::Bundle local;
+        libConfig::Bundle* b = get_bundle(local);
+        if(!b){
             return EXIT_FAILURE;
         }
-        std::vector<std::string> res = b.findFilesByName(argv[2]);
+        std::vector<std::string> res = b->findFilesByName(args[1]);
         for(const std::string& p : res){
-            std::cout << p << std::endl;
+            out << p << std::endl;
         }
     }
     else if(mode == "find1")
     {
-        if(argc < 3){
-            std::cerr << "No filename to search for was given" << std::endl;
+        if(argc < 2){
+            err << "No filename to search for was given" << std::endl;
             return EXIT_FAILURE;
         }
-        libConfig::Bundle b;
-        if(!b.initialize(false)){
+        libConfig::Bundle local;
+        libConfig::Bundle* b = get_bundle(local);
+        if(!b){
             return EXIT_FAILURE;
         }
-        std::cout << b.findFileByName(argv[2]) << std::endl;
+        out << b->findFileByName(args[1]) << std::endl;
     }
     else if(mode == "findext")
     {
         std::string ext = "";
         std::string rel_path = "";
-        if(argc == 3){
-            ext = argv[2];
+        if(argc == 2){
+            ext = args[1];
         }
-        else if(argc == 4){
-            rel_path = argv[2];
-            ext = argv[3];
+        else if(argc == 3){
+            rel_path = args[1];
+            ext = args[2];
         }
         else{
-            std::cerr << "Wrong number of arguments for 'findext'" << std::endl;
-            std::clog << "findext expects one or two arguments. Either \n"
-                      << "    findext [EXT]\n"
-                      << "or \n"
-                      << "    findext [BUNDLE_RELATIVE_SUBFOLDER] [EXT]\n"
-                      << "Note that EXT must be given with trailing dot (e.g. "
-                      << "'.txt')" << std::endl;
+            err << "Wrong number of arguments for 'findext'" << std::endl;
+            err << "findext expects one or two arguments. Either \n"
+                << "    findext [EXT]\n"
+                << "or \n"
+                << "    findext [BUNDLE_RELATIVE_SUBFOLDER] [EXT]\n"
+                << "Note that EXT must be given with trailing dot (e.g. "
+                << "'.txt')" << std::endl;
             return EXIT_FAILURE;
         }
-        libConfig::Bundle b;
-        if(!b.initialize(false))
+        libConfig::Bundle local;
+        libConfig::Bundle* b = get_bundle(local);
+        if(!b)
         {
             return EXIT_FAILURE;
         }
         else{
-            std::vector<std::string> res = b.findFilesByExtension(rel_path, ext);
+            std::vector<std::string> res = b->findFilesByExtension(rel_path, ext);
             for(const std::string& p : res){
-                std::cout << p << std::endl;
+                out << p << std::endl;
             }
         }
     }
+    else if(mode == "config")
+    {
+        if(argc < 2){
+            err << "No task model name was given" << std::endl;
+            return EXIT_FAILURE;
+        }
+        libConfig::Bundle local;
+        libConfig::Bundle* b = get_bundle(local, true);
+        if(!b){
+            return EXIT_FAILURE;
+        }
+        std::vector<std::string> sections(args.begin() + 2, args.end());
+        if(sections.empty()){
+            sections.push_back("default");
+        }
+        libConfig::Configuration config = b->taskConfigurations.getConfig(args[1], sections);
+        out << config.toYaml() << std::endl;
+    }
+    else if(mode == "resolve")
+    {
+        if(argc < 2 || argc > 3){
+            err << "resolve expects a deployment description and optionally "
+                << "an output file" << std::endl;
+            return EXIT_FAILURE;
+        }
+        std::vector<libConfig::DeploymentEntry> entries =
+                libConfig::ResolvedDeployment::loadDescription(args[1]);
+        libConfig::Bundle local;
+        libConfig::Bundle* b = get_bundle(local, true);
+        if(!b){
+            return EXIT_FAILURE;
+        }
+        libConfig::ResolvedDeployment deployment;
+        deployment.resolve(b->taskConfigurations, entries);
+        if(argc == 3){
+            deployment.save(args[2]);
+        }else{
+            out << deployment.toYaml();
+        }
+    }
     else
     {
-        std::cerr << "Unknown mode '" << mode << "'" <<std::endl;
+        err << "Unknown mode '" << mode << "'" <<std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+
+int run_request(const std::vector<std::string>& args, std::ostream& out,
+                std::ostream& err)
+{
+    try{
+        return handle_request(args, out, err);
+    }
+    catch(std::exception& ex){
+        err << "Error: " << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
+
+//Creates the directory of the sockets if needed. Returns false if it is not
+//a directory that only the user can access, as other users could then bind
+//the socket first or remove it.
+bool private_directory(const std::string& dir)
+{
+    if(mkdir(dir.c_str(), 0700) != 0 && errno != EEXIST){
+        return false;
+    }
+    struct stat st;
+    return lstat(dir.c_str(), &st) == 0 && S_ISDIR(st.st_mode) &&
+            st.st_uid == getuid() && (st.st_mode & 0077) == 0;
+}
+
+//The daemon serves one environment. Clients with a different ROCK_BUNDLE or
+//ROCK_BUNDLE_PATH use a different socket. Empty if there is no private
+//directory for it.
+std::string socket_path()
+{
+    const char* path = getenv("ROCK_BUNDLE_SOCKET");
+    if(path && path[0] != '\0'){
+        return path;
+    }
+    const char* bundlePath = getenv("ROCK_BUNDLE_PATH");
+    std::string env = libConfig::Bundle::getSelectedBundleName() + "\n" +
+            (bundlePath ? bundlePath : "");
+    std::stringstream dir;
+    const char* runtimeDir = getenv("XDG_RUNTIME_DIR");
+    if(runtimeDir && runtimeDir[0] != '\0'){
+        dir << runtimeDir << "/rock-bundle";
+    }else{
+        dir << "/tmp/rock-bundle-" << getuid();
+    }
+    if(!private_directory(dir.str())){
+        return "";
+    }
+    std::stringstream ss;
+    ss << dir.str() << "/" << std::hex << std::hash<std::string>()(env) << ".sock";
+    return ss.str();
+}
+
+//The daemon and its clients only talk to processes of the same user
+bool peer_is_same_user(int fd)
+{
+    ucred cred;
+    socklen_t size = sizeof(cred);
+    return getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &size) == 0 &&
+            cred.uid == getuid();
+}
+
+bool write_all(int fd, const void* data, size_t size)
+{
+    const char* p = static_cast<const char*>(data);
+    while(size > 0)
+    {
+        ssize_t n = send(fd, p, size, MSG_NOSIGNAL);
+        if(n < 0 && errno == EINTR){
+            continue;
+        }
+        if(n <= 0){
+            return false;
+        }
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+bool read_all(int fd, void* data, size_t size)
+{
+    char* p = static_cast<char*>(data);
+    while(size > 0)
+    {
+        ssize_t n = recv(fd, p, size, 0);
+        if(n < 0 && errno == EINTR){
+            continue;
+        }
+        if(n <= 0){
+            return false;
+        }
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+//Messages are sequences of strings, each prefixed with its length
+bool write_string(int fd, const std::string& str)
+{
+    uint32_t size = str.size();
+    return write_all(fd, &size, sizeof(size)) && write_all(fd, str.data(), size);
+}
+
+bool read_string(int fd, std::string& str)
+{
+    uint32_t size;
+    if(!read_all(fd, &size, sizeof(size)) || size > (64u << 20)){
+        return false;
+    }
+    str.resize(size);
+    return read_all(fd, &str[0], size);
+}
+
+int connect_socket(const std::string& path)
+{
+    sockaddr_un addr;
+    if(path.empty() || path.size() >= sizeof(addr.sun_path)){
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path.c_str());
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if(fd < 0){
+        return -1;
+    }
+    if(connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0){
+        close(fd);
+        return -1;
+    }
+    if(!peer_is_same_user(fd)){
+        std::cerr << "Ignoring " << path << ", it is served by another user" << std::endl;
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+volatile sig_atomic_t stopRequested = 0;
+
+void request_stop(int)
+{
+    stopRequested = 1;
+}
+
+//Answers the requests of one client connection
+bool serve_connection(int fd, libConfig::Bundle& bundle)
+{
+    uint32_t count;
+    std::vector<std::string> args;
+    if(!read_all(fd, &count, sizeof(count)) || count == 0 || count > 1024){
+        return true;
+    }
+    for(uint32_t i = 0; i < count; i++){
+        std::string arg;
+        if(!read_string(fd, arg)){
+            return true;
+        }
+        args.push_back(arg);
+    }
+
+    std::stringstream out, err;
+    int32_t ret = EXIT_SUCCESS;
+    bool keepRunning = true;
+    if(args[0] == "stop"){
+        keepRunning = false;
+    }else if(args[0] == "refresh"){
+        //Replaced only on success, the served bundle stays usable otherwise
+        libConfig::Bundle next;
+        next.taskConfigurations.setLazyLoading(bundle.taskConfigurations.isLazyLoading());
+        try{
+            if(next.initialize(true)){
+                bundle = next;
+            }else{
+                err << "Could not initialize the bundle again" << std::endl;
+                ret = EXIT_FAILURE;
+            }
+        }catch(std::exception& ex){
+            err << "Could not initialize the bundle again: " << ex.what() << std::endl;
+            ret = EXIT_FAILURE;
+        }
+    }else{
+        ret = run_request(args, out, err);
+    }
+    write_all(fd, &ret, sizeof(ret)) && write_string(fd, out.str()) &&
+            write_string(fd, err.str());
+    return keepRunning;
+}
+
+int serve(const std::vector<std::string>& args)
+{
+    unsigned idleTimeout = 0;
+    if(args.size() > 1){
+        idleTimeout = std::stoul(args[1]);
+    }
+
+    libConfig::Bundle bundle;
+    if(!get_bundle(bundle, true)){
+        return EXIT_FAILURE;
+    }
+    servedBundle = &bundle;
+
+    const std::string path = socket_path();
+    if(path.empty()){
+        std::cerr << "No private directory for the socket of the daemon" << std::endl;
+        return EXIT_FAILURE;
+    }
+    int probe = connect_socket(path);
+    if(probe >= 0){
+        close(probe);
+        std::cerr << "A daemon is already serving " << path << std::endl;
+        return EXIT_FAILURE;
+    }
+    //Left behind by a daemon that did not exit cleanly. Only own sockets are
+    //removed.
+    struct stat st;
+    if(lstat(path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode) && st.st_uid == getuid()){
+        unlink(path.c_str());
+    }
+
+    sockaddr_un addr;
+    if(path.size() >= sizeof(addr.sun_path)){
+        std::cerr << "Socket path " << path << " is too long" << std::endl;
+        return EXIT_FAILURE;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path.c_str());
+    int listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    mode_t oldMask = umask(0077);
+    bool bound = listenFd >= 0 &&
+            bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0 &&
+            listen(listenFd, 64) == 0;
+    umask(oldMask);
+    if(!bound){
+        std::cerr << "Could not listen on " << path << ": " << strerror(errno) << std::endl;
+        if(listenFd >= 0){
+            close(listenFd);
+        }
+        return EXIT_FAILURE;
+    }
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = request_stop;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+
+    std::clog << "Serving bundle " << bundle.getActiveBundleName() << " on " << path << std::endl;
+    bool running = true;
+    while(running && !stopRequested)
+    {
+        pollfd pfd = {listenFd, POLLIN, 0};
+        int ready = poll(&pfd, 1, idleTimeout ? int(idleTimeout * 1000) : -1);
+        if(ready < 0 && errno == EINTR){
+            continue;
+        }
+        if(ready <= 0){
+            //Idle timeout or error
+            break;
+        }
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+        if(fd < 0){
+            continue;
+        }
+        if(!peer_is_same_user(fd)){
+            close(fd);
+            continue;
+        }
+        //Connections are served one at a time, a stalled client must not
+        //block the others
+        timeval timeout = {5, 0};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        running = serve_connection(fd, bundle);
+        close(fd);
+    }
+
+    close(listenFd);
+    unlink(path.c_str());
+    servedBundle = nullptr;
+    return EXIT_SUCCESS;
+}
+
+//Answers one query per line of stdin. Each answer is a header line with the
+//status (OK or ERROR) and the size of the following payload in bytes.
+int batch()
+{
+    libConfig::Bundle bundle;
+    if(!get_bundle(bundle, true)){
         return EXIT_FAILURE;
     }
+    servedBundle = &bundle;
+
+    std::string line;
+    while(std::getline(std::cin, line))
+    {
+        std::vector<std::string> args = libConfig::Bundle::tokenize(line, " \t\r");
+        if(args.empty()){
+            continue;
+        }
+        std::stringstream out, err;
+        int ret = run_request(args, out, err);
+        std::string payload = ret == EXIT_SUCCESS ? out.str() : err.str();
+        std::cout << (ret == EXIT_SUCCESS ? "OK " : "ERROR ") << payload.size() << "\n"
+                  << payload << std::flush;
+    }
+    servedBundle = nullptr;
     return EXIT_SUCCESS;
 }
 
+//Sends the request to the daemon. Returns false if no daemon answered, the
+//request has to be executed directly then.
+bool send_to_daemon(const std::vector<std::string>& args, int& ret)
+{
+    int fd = connect_socket(socket_path());
+    if(fd < 0){
+        return false;
+    }
+    timeval timeout = {30, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    uint32_t count = args.size();
+    bool ok = write_all(fd, &count, sizeof(count));
+    for(size_t i = 0; ok && i < args.size(); i++){
+        ok = write_string(fd, args[i]);
+    }
+    int32_t code;
+    std::string out, err;
+    ok = ok && read_all(fd, &code, sizeof(code)) && read_string(fd, out) &&
+            read_string(fd, err);
+    close(fd);
+    if(!ok){
+        return false;
+    }
+    std::cout << out << std::flush;
+    std::cerr << err << std::flush;
+    ret = code;
+    return true;
+}
+
+int client(const std::vector<std::string>& args)
+{
+    if(args.empty()){
+        std::cerr << "Mode must be specified after 'client'" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::vector<std::string> request = args;
+    if(request[0] == "resolve"){
+        //The daemon runs in another working directory
+        for(size_t i = 1; i < request.size(); i++){
+            request[i] = boost::filesystem::absolute(request[i]).string();
+        }
+    }
+    int ret;
+    if(send_to_daemon(request, ret)){
+        return ret;
+    }
+    if(args[0] == "stop" || args[0] == "refresh"){
+        //No daemon running, nothing to do
+        return EXIT_SUCCESS;
+    }
+    return run_request(args, std::cout, std::cerr);
+}
 
 int main(int argc, char** argv)
 {
@@ -171,11 +637,21 @@ int main(int argc, char** argv)
         return EXIT_FAILURE;
     }
 
+    std::vector<std::string> args(argv + 1, argv + argc);
     try{
-        return handle_request(argc, argv);
+        if(args[0] == "serve"){
+            return serve(args);
+        }
+        if(args[0] == "batch"){
+            return batch();
+        }
+        if(args[0] == "client"){
+            return client(std::vector<std::string>(args.begin() + 1, args.end()));
+        }
     }
     catch(std::exception& ex){
         std::cerr << "Error: " << ex.what() << std::endl;
         return EXIT_FAILURE;
     }
+    return run_request(args, std::cout, std::cerr);
 }
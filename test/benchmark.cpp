@@ -0,0 +1,404 @@
+#include "synthetic_bundles.hpp"
+#include "heap_counter.hpp"
+#include "benchmark_results.hpp"
+#include "Bundle.hpp"
+#include "YAMLConfiguration.hpp"
+#include "TypelibConfiguration.hpp"
+#include <typelib/typemodel.hh>
+#include <typelib/value.hh>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <functional>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+/*
+ * Benchmarks of the configuration model and the bundle loading on a
+ * synthetic bundle hierarchy, see usage().
+ *
+ * Micro benchmarks are repeated until a sample takes at least 10 ms, macro
+ * benchmarks (files and bundles) run once per sample. Bundle::initialize
+ * is measured with warm caches, as in a process that initializes repeatedly.
+ * Heap allocations are counted by the operator new of heap_counter.cpp, on
+ * all threads.
+ */
+
+namespace
+{
+
+void usage()
+{
+    std::cout <<
+    R"USAGE(
+lib_config_benchmark runs benchmarks on a generated bundle hierarchy.
+
+USAGE:
+    lib_config_benchmark [OPTIONS]
+
+OPTIONS:
+    --list              : Print the names of the benchmarks and exit
+    --filter TEXT       : Only run benchmarks whose name contains TEXT
+    --samples N         : Samples per benchmark (default 15)
+    --dir PATH          : Directory the bundles are generated in
+                          (default /tmp/lib_config_benchmark)
+    --bundles N         : Number of bundles (default 4)
+    --depth N           : Dependency levels below the selected bundle (default 2)
+    --tasks N           : Task model files per bundle, at least 1 (default 10)
+    --sections N        : Sections per file (default 5)
+    --properties N      : Properties per section (default 20)
+    --array N           : Elements of array properties (default 8)
+    --insertions N      : Properties per section with insertions (default 1)
+    --json PATH         : Write the results as JSON to PATH
+    --baseline PATH     : Compare the results with the JSON results in PATH,
+                          exit with 1 if any benchmark regressed
+    --compare PATH      : Compare the JSON results in PATH with the baseline
+                          instead of running the benchmarks
+    --tolerance F       : Allowed increase of the median time as fraction
+                          (default 0.1)
+    --alloc-tolerance F : Allowed increase of the allocations per operation
+                          as fraction (default 0.05)
+
+The baseline has to be recorded with the same bundle options. Comparisons
+are only meaningful on the same machine and build type.
+Benchmarks of the baseline that did not run count as regressions, unless
+they were excluded with --filter.
+)USAGE";
+}
+
+struct Benchmark
+{
+    std::string name;
+    //Macro benchmarks run once per sample
+    bool macro;
+    std::function<void()> run;
+};
+
+double seconds(const std::function<void()>& fn, size_t iterations)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(size_t i = 0; i < iterations; i++){
+        fn();
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+libConfig::BenchmarkResult measure(const Benchmark& benchmark, size_t samples)
+{
+    //The first run warms up caches and gives the iteration count
+    double once = seconds(benchmark.run, 1);
+    size_t iterations = 1;
+    if(!benchmark.macro && once < 0.01){
+        iterations = std::max<size_t>(1, 0.01 / std::max(once, 1e-9));
+    }
+    std::vector<double> times;
+    libConfig::HeapCounter::Scope heap;
+    for(size_t s = 0; s < samples; s++){
+        times.push_back(seconds(benchmark.run, iterations) / iterations);
+    }
+    libConfig::BenchmarkResult result =
+            libConfig::BenchmarkResult::fromSamples(benchmark.name, iterations, times);
+    const double runs = samples * iterations;
+    result.allocations = heap.delta().allocations / runs;
+    result.allocatedBytes = heap.delta().allocatedBytes / runs;
+    return result;
+}
+
+std::string formatTime(double seconds)
+{
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(2);
+    if(seconds < 1e-6){
+        ss << seconds * 1e9 << " ns";
+    }else if(seconds < 1e-3){
+        ss << seconds * 1e6 << " us";
+    }else{
+        ss << seconds * 1e3 << " ms";
+    }
+    return ss.str();
+}
+
+//Typelib model with one field per property: doubles and double arrays
+struct SyntheticTypes
+{
+    Typelib::Numeric doubleT;
+    Typelib::Array arrayT;
+    Typelib::Compound structT;
+
+    SyntheticTypes(const libConfig::SyntheticBundleSpec& spec) :
+        doubleT("/double", sizeof(double), Typelib::Numeric::Float),
+        arrayT(doubleT, std::max<size_t>(1, spec.arraySize)),
+        structT("/SyntheticStruct")
+    {
+        size_t offset = 0;
+        for(size_t p = 0; p < spec.propertiesPerSection; p++)
+        {
+            const Typelib::Type& type = p % 2 ? static_cast<const Typelib::Type&>(arrayT) : doubleT;
+            structT.addField("prop_" + std::to_string(p), type, offset);
+            offset += type.getSize();
+        }
+        structT.setSize(offset);
+    }
+};
+
+std::string formatBytes(double bytes)
+{
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(1);
+    if(bytes < 1024){
+        ss << bytes << " B";
+    }else if(bytes < 1024 * 1024){
+        ss << bytes / 1024 << " KiB";
+    }else{
+        ss << bytes / (1024 * 1024) << " MiB";
+    }
+    return ss.str();
+}
+
+//Heap retained by the loaded configurations, measured and as reported by
+//memoryUsage()
+void printMemory(const std::vector<std::string>& taskFiles, const std::string& task,
+                 const std::vector<std::string>& sections)
+{
+    libConfig::HeapCounter::Scope loading;
+    libConfig::TaskConfigurations configs;
+    configs.setLazyLoading(false);
+    configs.initialize(taskFiles);
+    long retained = loading.delta().liveBytes;
+    size_t models = configs.getTaskModelNames().size();
+
+    libConfig::HeapCounter::Scope merging;
+    libConfig::Configuration merged = configs.getConfig(task, sections);
+    long mergedRetained = merging.delta().liveBytes;
+
+    std::cout << "\nmemory" << std::endl;
+    std::cout << "  TaskConfigurations        : " << formatBytes(retained) <<
+                 " retained, memoryUsage() " << formatBytes(configs.memoryUsage()) << std::endl;
+    std::cout << "  per task model            : " << formatBytes(double(retained) / models) <<
+                 " retained, memoryUsage() " <<
+                 formatBytes(configs.getMultiConfig(task).memoryUsage()) << std::endl;
+    std::cout << "  merged Configuration      : " << formatBytes(mergedRetained) <<
+                 " retained, memoryUsage() " << formatBytes(merged.memoryUsage()) << std::endl;
+}
+
+libConfig::Configuration parseSection(const std::string& yml)
+{
+    libConfig::YAMLConfigParser parser;
+    libConfig::Configuration config("section");
+    parser.parseYAML(config, libConfig::YAMLConfigParser::applyStringVariableInsertions(yml));
+    return config;
+}
+
+size_t parseSize(const char* arg)
+{
+    return std::stoul(arg);
+}
+
+//Exit code 1 for regressions, 2 for errors
+int compare(const std::string& baselinePath, const libConfig::BenchmarkRun& run,
+            const libConfig::BenchmarkTolerance& tolerance)
+{
+    try{
+        libConfig::BenchmarkRun baseline = libConfig::BenchmarkRun::load(baselinePath);
+        std::cout << "\nComparison with " << baselinePath << std::endl;
+        if(!libConfig::compareBenchmarkRuns(baseline, run, tolerance, std::cout)){
+            std::cout << "Benchmarks regressed or are missing" << std::endl;
+            return 1;
+        }
+    }catch(std::exception& e){
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 2;
+    }
+    return EXIT_SUCCESS;
+}
+}
+
+int main(int argc, char** argv)
+{
+    libConfig::SyntheticBundleSpec spec;
+    std::string dir = "/tmp/lib_config_benchmark";
+    std::string filter;
+    size_t samples = 15;
+    bool list = false;
+    std::string jsonPath, baselinePath, comparePath;
+    libConfig::BenchmarkTolerance tolerance;
+    for(int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if(arg == "--list"){
+            list = true;
+            continue;
+        }
+        if(arg == "--help" || i + 1 >= argc){
+            usage();
+            return arg == "--help" ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+        const char* value = argv[++i];
+        if(arg == "--filter") filter = value;
+        else if(arg == "--samples") samples = std::max<size_t>(1, parseSize(value));
+        else if(arg == "--dir") dir = value;
+        else if(arg == "--bundles") spec.bundles = std::max<size_t>(1, parseSize(value));
+        else if(arg == "--depth") spec.dependencyDepth = parseSize(value);
+        else if(arg == "--tasks") spec.taskFiles = std::max<size_t>(1, parseSize(value));
+        else if(arg == "--sections") spec.sectionsPerFile = std::max<size_t>(1, parseSize(value));
+        else if(arg == "--properties") spec.propertiesPerSection = parseSize(value);
+        else if(arg == "--array") spec.arraySize = parseSize(value);
+        else if(arg == "--insertions") spec.insertionsPerSection = parseSize(value);
+        else if(arg == "--json") jsonPath = value;
+        else if(arg == "--baseline") baselinePath = value;
+        else if(arg == "--compare") comparePath = value;
+        else if(arg == "--tolerance") tolerance.time = std::stod(value);
+        else if(arg == "--alloc-tolerance") tolerance.allocations = std::stod(value);
+        else{
+            std::cerr << "Unknown option " << arg << std::endl;
+            usage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    if(!comparePath.empty())
+    {
+        if(baselinePath.empty()){
+            std::cerr << "--compare needs a --baseline" << std::endl;
+            return 2;
+        }
+        try{
+            return compare(baselinePath, libConfig::BenchmarkRun::load(comparePath), tolerance);
+        }catch(std::exception& e){
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 2;
+        }
+    }
+
+    libConfig::SyntheticBundles bundles = libConfig::generateSyntheticBundles(dir, spec);
+    setenv("ROCK_BUNDLE_PATH", bundles.searchPath.c_str(), 1);
+    setenv("ROCK_BUNDLE", bundles.selected.c_str(), 1);
+
+    libConfig::Bundle bundle;
+    bundle.taskConfigurations.setLazyLoading(false);
+    if(!bundle.initialize(true)){
+        std::cerr << "Could not initialize the synthetic bundles in " << dir << std::endl;
+        return EXIT_FAILURE;
+    }
+    const std::vector<std::string> taskFiles =
+            bundle.findFilesByExtension("config/orogen", ".yml");
+    const std::string firstTask = bundles.taskModels[0];
+    const std::string firstFile = bundle.findFileByName("config/orogen/" + firstTask + ".yml");
+
+    //Inputs of the micro benchmarks
+    const std::string sectionText = libConfig::syntheticSection(spec, 0, 1);
+    const libConfig::Configuration lowSection = parseSection(libConfig::syntheticSection(spec, 1, 0));
+    const libConfig::Configuration highSection = parseSection(sectionText);
+    libConfig::Configuration merged;
+    merged.merge(lowSection);
+    merged.merge(highSection);
+    libConfig::Configuration mergedCopy;
+    mergedCopy.merge(lowSection);
+    mergedCopy.merge(highSection);
+
+    SyntheticTypes types(spec);
+    std::vector<double> data(types.structT.getSize() / sizeof(double) + 1);
+    for(size_t i = 0; i < data.size(); i++){
+        data[i] = i * 0.25;
+    }
+    Typelib::Value value(data.data(), types.structT);
+    libConfig::TypelibConfiguration typelibConfig;
+
+    std::vector<Benchmark> benchmarks = {
+        {"micro/applyStringVariableInsertions", false, [&](){
+            libConfig::YAMLConfigParser::applyStringVariableInsertions(sectionText);
+        }},
+        {"micro/parseYAML", false, [&](){
+            parseSection(sectionText);
+        }},
+        {"micro/Configuration::merge", false, [&](){
+            libConfig::Configuration result;
+            result.merge(lowSection);
+            result.merge(highSection);
+        }},
+        {"micro/Configuration::operator==", false, [&](){
+            if(!(merged == mergedCopy)){
+                std::abort();
+            }
+        }},
+        {"micro/Configuration::toYaml", false, [&](){
+            merged.toYaml();
+        }},
+        {"micro/TaskConfigurations::getConfig", false, [&](){
+            bundle.taskConfigurations.getConfig(firstTask, bundles.sections);
+        }},
+        {"micro/TypelibConfiguration::getFromValue", false, [&](){
+            typelibConfig.getFromValue(value);
+        }},
+        {"macro/YAMLConfigParser::loadConfigFile", true, [&](){
+            libConfig::YAMLConfigParser parser;
+            std::map<std::string, libConfig::Configuration> sections;
+            parser.loadConfigFile(firstFile, sections);
+        }},
+        {"macro/TaskConfigurations::initialize", true, [&](){
+            libConfig::TaskConfigurations configs;
+            configs.setLazyLoading(false);
+            configs.initialize(taskFiles);
+        }},
+        {"macro/Bundle::initialize", true, [&](){
+            libConfig::Bundle b;
+            b.taskConfigurations.setLazyLoading(false);
+            b.initialize(true);
+        }},
+        {"macro/Bundle::initialize(lazy)", true, [&](){
+            libConfig::Bundle b;
+            b.taskConfigurations.setLazyLoading(true);
+            b.initialize(true);
+        }},
+        {"macro/Bundle::initialize(no task configs)", true, [&](){
+            libConfig::Bundle b;
+            b.initialize(false);
+        }},
+    };
+
+    if(list){
+        for(const Benchmark& benchmark : benchmarks){
+            std::cout << benchmark.name << std::endl;
+        }
+        return EXIT_SUCCESS;
+    }
+
+    std::cout << bundles.bundles.size() << " bundles, " << taskFiles.size() <<
+                 " task files, " << spec.sectionsPerFile << " sections of " <<
+                 spec.propertiesPerSection << " properties" << std::endl;
+    std::cout << std::left << std::setw(48) << "benchmark" << std::right <<
+                 std::setw(12) << "median" << std::setw(12) << "p90" <<
+                 std::setw(12) << "max" << std::setw(12) << "allocs/op" <<
+                 std::setw(12) << "bytes/op" << std::setw(12) << "iterations" << std::endl;
+    libConfig::BenchmarkRun run;
+    run.spec = spec;
+    run.filter = filter;
+    for(const Benchmark& benchmark : benchmarks)
+    {
+        if(benchmark.name.find(filter) == std::string::npos){
+            continue;
+        }
+        libConfig::BenchmarkResult result = measure(benchmark, samples);
+        run.results.push_back(result);
+        std::cout << std::left << std::setw(48) << result.name << std::right <<
+                     std::setw(12) << formatTime(result.median) <<
+                     std::setw(12) << formatTime(result.p90) <<
+                     std::setw(12) << formatTime(result.max) <<
+                     std::setw(12) << std::fixed << std::setprecision(1) << result.allocations <<
+                     std::setw(12) << formatBytes(result.allocatedBytes) <<
+                     std::setw(12) << result.iterations << std::endl;
+    }
+    if(filter.empty()){
+        printMemory(taskFiles, firstTask, bundles.sections);
+    }
+    if(!jsonPath.empty()){
+        run.save(jsonPath);
+    }
+    if(!baselinePath.empty()){
+        return compare(baselinePath, run, tolerance);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,230 @@
+#include "benchmark_results.hpp"
+#include "JsonUtils.hpp"
+#include <yaml-cpp/yaml.h>
+#include <algorithm>
+#include <numeric>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <stdexcept>
+
+using namespace libConfig;
+
+namespace
+{
+//Linear interpolation between the closest ranks of sorted values
+double percentile(const std::vector<double>& sorted, double fraction)
+{
+    if(sorted.empty()){
+        return 0;
+    }
+    double rank = fraction * (sorted.size() - 1);
+    size_t lower = static_cast<size_t>(rank);
+    size_t upper = std::min(lower + 1, sorted.size() - 1);
+    return sorted[lower] + (sorted[upper] - sorted[lower]) * (rank - lower);
+}
+
+//Fields of SyntheticBundleSpec in the order they are written
+std::vector<std::pair<std::string, size_t*> > specFields(SyntheticBundleSpec& spec)
+{
+    return {
+        {"bundles", &spec.bundles},
+        {"dependencyDepth", &spec.dependencyDepth},
+        {"taskFiles", &spec.taskFiles},
+        {"sectionsPerFile", &spec.sectionsPerFile},
+        {"propertiesPerSection", &spec.propertiesPerSection},
+        {"arraySize", &spec.arraySize},
+        {"insertionsPerSection", &spec.insertionsPerSection},
+    };
+}
+
+std::string percent(double ratio)
+{
+    std::stringstream ss;
+    ss << std::showpos << std::fixed << std::setprecision(1) << (ratio - 1) * 100 << "%";
+    return ss.str();
+}
+}
+
+BenchmarkResult::BenchmarkResult() :
+    iterations(0), samples(0), mean(0), min(0), p25(0), median(0), p75(0), p90(0),
+    max(0), allocations(0), allocatedBytes(0)
+{
+}
+
+BenchmarkResult BenchmarkResult::fromSamples(const std::string &name, size_t iterations,
+                                             std::vector<double> samples)
+{
+    BenchmarkResult result;
+    result.name = name;
+    result.iterations = iterations;
+    result.samples = samples.size();
+    if(samples.empty()){
+        return result;
+    }
+    std::sort(samples.begin(), samples.end());
+    result.mean = std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
+    result.min = samples.front();
+    result.p25 = percentile(samples, 0.25);
+    result.median = percentile(samples, 0.5);
+    result.p75 = percentile(samples, 0.75);
+    result.p90 = percentile(samples, 0.9);
+    result.max = samples.back();
+    return result;
+}
+
+std::string BenchmarkRun::toJson() const
+{
+    SyntheticBundleSpec specCopy = spec;
+    std::stringstream ss;
+    ss << std::setprecision(9);
+    ss << "{\n  \"spec\": {";
+    bool first = true;
+    for(const auto& field : specFields(specCopy)){
+        ss << (first ? "" : ", ") << jsonString(field.first) << ": " << *field.second;
+        first = false;
+    }
+    ss << "},\n  \"filter\": " << jsonString(filter) << ",\n  \"benchmarks\": [";
+    for(size_t i = 0; i < results.size(); i++)
+    {
+        const BenchmarkResult& r = results[i];
+        ss << (i ? ",\n" : "\n") << "    {"
+           << "\"name\": " << jsonString(r.name)
+           << ", \"iterations\": " << r.iterations
+           << ", \"samples\": " << r.samples
+           << ", \"mean\": " << r.mean
+           << ", \"min\": " << r.min
+           << ", \"p25\": " << r.p25
+           << ", \"median\": " << r.median
+           << ", \"p75\": " << r.p75
+           << ", \"p90\": " << r.p90
+           << ", \"max\": " << r.max
+           << ", \"allocations\": " << r.allocations
+           << ", \"allocatedBytes\": " << r.allocatedBytes << "}";
+    }
+    ss << (results.empty() ? "" : "\n  ") << "]\n}\n";
+    return ss.str();
+}
+
+void BenchmarkRun::save(const std::string &path) const
+{
+    std::ofstream fout(path);
+    fout << toJson();
+    fout.close();
+    if(!fout){
+        throw std::runtime_error("Could not write benchmark results " + path);
+    }
+}
+
+BenchmarkRun BenchmarkRun::load(const std::string &path)
+{
+    //JSON is a subset of YAML
+    YAML::Node doc;
+    try{
+        doc = YAML::LoadFile(path);
+    }catch(YAML::Exception& e){
+        throw std::runtime_error("Could not read benchmark results " + path + ": " + e.what());
+    }
+    if(!doc["spec"] || !doc["benchmarks"]){
+        throw std::runtime_error(path + " does not contain benchmark results");
+    }
+
+    BenchmarkRun run;
+    run.filter = doc["filter"].as<std::string>("");
+    for(const auto& field : specFields(run.spec)){
+        if(doc["spec"][field.first]){
+            *field.second = doc["spec"][field.first].as<size_t>();
+        }
+    }
+    for(const YAML::Node& node : doc["benchmarks"])
+    {
+        BenchmarkResult r;
+        r.name = node["name"].as<std::string>();
+        r.iterations = node["iterations"].as<size_t>(0);
+        r.samples = node["samples"].as<size_t>(0);
+        r.mean = node["mean"].as<double>(0);
+        r.min = node["min"].as<double>(0);
+        r.p25 = node["p25"].as<double>(0);
+        r.median = node["median"].as<double>(0);
+        r.p75 = node["p75"].as<double>(0);
+        r.p90 = node["p90"].as<double>(0);
+        r.max = node["max"].as<double>(0);
+        r.allocations = node["allocations"].as<double>(0);
+        r.allocatedBytes = node["allocatedBytes"].as<double>(0);
+        run.results.push_back(r);
+    }
+    return run;
+}
+
+BenchmarkTolerance::BenchmarkTolerance() :
+    time(0.1), allocations(0.05)
+{
+}
+
+bool libConfig::compareBenchmarkRuns(const BenchmarkRun &baseline, const BenchmarkRun &current,
+                                     const BenchmarkTolerance &tolerance, std::ostream &out)
+{
+    SyntheticBundleSpec baseSpec = baseline.spec;
+    SyntheticBundleSpec currentSpec = current.spec;
+    std::vector<std::pair<std::string, size_t*> > baseFields = specFields(baseSpec);
+    std::vector<std::pair<std::string, size_t*> > currentFields = specFields(currentSpec);
+    for(size_t i = 0; i < baseFields.size(); i++){
+        if(*baseFields[i].second != *currentFields[i].second){
+            throw std::runtime_error("The runs used different bundles, " + baseFields[i].first +
+                                     " is " + std::to_string(*baseFields[i].second) +
+                                     " in the baseline and " +
+                                     std::to_string(*currentFields[i].second) + " now");
+        }
+    }
+
+    bool ok = true;
+    out << std::left << std::setw(48) << "benchmark" << std::right << std::setw(12) <<
+           "time" << std::setw(12) << "allocs" << "  result" << std::endl;
+    for(const BenchmarkResult& base : baseline.results)
+    {
+        std::vector<BenchmarkResult>::const_iterator it = std::find_if(
+                    current.results.begin(), current.results.end(),
+                    [&base](const BenchmarkResult& r){ return r.name == base.name; });
+        out << std::left << std::setw(48) << base.name << std::right;
+        if(it == current.results.end()){
+            out << std::setw(12) << "-" << std::setw(12) << "-";
+            if(!current.filter.empty() && base.name.find(current.filter) == std::string::npos){
+                out << "  filtered" << std::endl;
+            }else{
+                ok = false;
+                out << "  MISSING" << std::endl;
+            }
+            continue;
+        }
+        double timeRatio = base.median > 0 ? it->median / base.median : 1;
+        //Half an allocation per operation is rounding
+        double allocationRatio = (it->allocations + 0.5) / (base.allocations + 0.5);
+        std::vector<std::string> regressions;
+        if(timeRatio > 1 + tolerance.time){
+            regressions.push_back("time");
+        }
+        if(allocationRatio > 1 + tolerance.allocations){
+            regressions.push_back("allocations");
+        }
+        out << std::setw(12) << percent(timeRatio) << std::setw(12) << percent(allocationRatio);
+        if(regressions.empty()){
+            out << "  ok" << std::endl;
+        }else{
+            ok = false;
+            out << "  REGRESSION (";
+            for(size_t i = 0; i < regressions.size(); i++){
+                out << (i ? ", " : "") << regressions[i];
+            }
+            out << ")" << std::endl;
+        }
+    }
+    for(const BenchmarkResult& r : current.results){
+        if(std::find_if(baseline.results.begin(), baseline.results.end(),
+                        [&r](const BenchmarkResult& b){ return b.name == r.name; }) ==
+                baseline.results.end()){
+            out << std::left << std::setw(48) << r.name << std::right << std::setw(12) << "-" <<
+                   std::setw(12) << "-" << "  new" << std::endl;
+        }
+    }
+    return ok;
+}
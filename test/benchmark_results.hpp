@@ -0,0 +1,77 @@
+#ifndef BENCHMARK_RESULTS_H
+#define BENCHMARK_RESULTS_H
+
+#include "synthetic_bundles.hpp"
+#include <string>
+#include <vector>
+#include <iosfwd>
+
+namespace libConfig
+{
+
+/**
+ * @brief Statistics of one benchmark, times in seconds per operation
+ */
+struct BenchmarkResult
+{
+    std::string name;
+    size_t iterations;
+    size_t samples;
+    double mean;
+    double min;
+    double p25;
+    double median;
+    double p75;
+    double p90;
+    double max;
+    //Heap allocations and allocated bytes per operation
+    double allocations;
+    double allocatedBytes;
+
+    BenchmarkResult();
+    static BenchmarkResult fromSamples(const std::string& name, size_t iterations,
+                                       std::vector<double> samples);
+};
+
+/**
+ * @brief Results of one benchmark run and the bundle shape it used
+ */
+struct BenchmarkRun
+{
+    SyntheticBundleSpec spec;
+    //Name filter the benchmarks were selected with, empty if all ran
+    std::string filter;
+    std::vector<BenchmarkResult> results;
+
+    std::string toJson() const;
+    void save(const std::string& path) const;
+    //Reads the output of save(), throws std::runtime_error on errors
+    static BenchmarkRun load(const std::string& path);
+};
+
+struct BenchmarkTolerance
+{
+    //Allowed relative increase of the median time, e.g. 0.1 for 10%
+    double time;
+    //Allowed relative increase of the allocations per operation
+    double allocations;
+
+    BenchmarkTolerance();
+};
+
+/**
+ * @brief Compares a run against a baseline and prints one line per
+ * benchmark to out
+ * Benchmarks of the baseline that are missing in the current run count as
+ * regressions, unless the current run was filtered and their name does not
+ * match the filter. New benchmarks are only reported. Throws
+ * std::runtime_error if the runs used different bundle shapes.
+ * @return false if any benchmark regressed beyond the tolerance or is
+ * missing
+ */
+bool compareBenchmarkRuns(const BenchmarkRun& baseline, const BenchmarkRun& current,
+                          const BenchmarkTolerance& tolerance, std::ostream& out);
+
+}
+
+#endif // BENCHMARK_RESULTS_H
@@ -1,11 +1,21 @@
 #include <boost/test/unit_test.hpp>
 #include "Bundle.hpp"
+#include "BundleWatcher.hpp"
+#include "LoadMetrics.hpp"
+#include "DependencyResolver.hpp"
+#include "BundleRegistry.hpp"
+#include "ResolvedDeployment.hpp"
+#include "synthetic_bundles.hpp"
+#include "heap_counter.hpp"
+#include "benchmark_results.hpp"
 #include "stdlib.h"
 #include <boost/filesystem.hpp>
 #include <iostream>
 #include <thread>         // std::this_thread::sleep_until
 #include <chrono>         // std::chrono::system_clock
 #include <ctime>          // std::time_t, std::tm, std::localtime, std::mktime
+#include <mutex>
+#include <condition_variable>
 
 namespace fs = boost::filesystem;
 const std::string bundle_path="/tmp/lib_config_bundles";
@@ -112,7 +122,7 @@ BOOST_AUTO_TEST_CASE(construction)
     //Should have depdendencies resolved.
     //Check that dependency resolution is breadth-first and that file finding
     //is done correctly (breadth-first)
-    std::vector<std::string> candidates = inst.findFilesByName("config/bundle.yml");
+    std::vector<std::string> candidates = inst2.findFilesByName("config/bundle.yml");
     BOOST_ASSERT(candidates.size() == 4);
     BOOST_CHECK_NE(candidates[0].find("first"), std::string::npos);
     BOOST_CHECK_NE(candidates[1].find("second"), std::string::npos);
@@ -130,8 +140,8 @@ BOOST_AUTO_TEST_CASE(construction)
 
     std::vector<std::string> folders;
     for(uint i=0; i<10; i++){
-        inst.createLogDirectory();
-        folders.push_back(inst.getLogDirectory());
+        inst2.createLogDirectory();
+        folders.push_back(inst2.getLogDirectory());
     }
 
     for(uint i=0; i<10; i++){
@@ -146,9 +156,9 @@ BOOST_AUTO_TEST_CASE(construction)
     }
 
     //Can detect config files by Task prototype
-    std::string p = inst.getConfigurationPath("my::Task");
+    std::string p = inst2.getConfigurationPath("my::Task");
     BOOST_CHECK_EQUAL(p, selected_bundle_dir.string()+"/config/orogen/my::Task.yml");
-    candidates = inst.getConfigurationPathsForTaskModel("my::Task");
+    candidates = inst2.getConfigurationPathsForTaskModel("my::Task");
     BOOST_ASSERT(candidates.size() == 4);
     BOOST_CHECK_NE(candidates[0].find("first"), std::string::npos);
     BOOST_CHECK_NE(candidates[1].find("second"), std::string::npos);
@@ -242,6 +252,28 @@ BOOST_AUTO_TEST_CASE(init_without_task_configuration)
     BOOST_CHECK_THROW(bundle.taskConfigurations.getConfig("my::Task", {"default"}), std::runtime_error);
 }
 
+BOOST_AUTO_TEST_CASE(initialization_metrics)
+{
+    clear_environment_variables();
+    setenv("ROCK_BUNDLE_PATH", bundle_path.c_str(), 1);
+    setenv("ROCK_BUNDLE", "first", 1);
+    libConfig::LoadMetrics::reset();
+    libConfig::LoadMetrics::setEnabled(true);
+    libConfig::Bundle bundle;
+    BOOST_REQUIRE(bundle.initialize());
+    libConfig::LoadMetrics::setEnabled(false);
+
+    libConfig::LoadMetricsReport report = libConfig::LoadMetrics::getReport();
+    BOOST_REQUIRE_EQUAL(report.initializations.size(), 1);
+    BOOST_CHECK(report.initializations[0].succeeded);
+    BOOST_CHECK_EQUAL(report.initializations[0].activeBundles, 4);
+    BOOST_CHECK(report.initializations[0].total >=
+                report.initializations[0].taskConfigLoading);
+    //One task configuration file per bundle
+    BOOST_CHECK_EQUAL(report.files.size(), 4);
+    libConfig::LoadMetrics::reset();
+}
+
 BOOST_AUTO_TEST_CASE(still_working_without_bundle_selected)
 {
     clear_environment_variables();
@@ -251,3 +283,762 @@ BOOST_AUTO_TEST_CASE(still_working_without_bundle_selected)
     BOOST_CHECK(!inst.initialize()); //Must be false because no bundle was selected
 }
 
+
+BOOST_AUTO_TEST_CASE(watch_task_configuration)
+{
+    clear_environment_variables();
+    setenv("ROCK_BUNDLE_PATH", bundle_path.c_str(), 1);
+    setenv("ROCK_BUNDLE", "first", 1);
+    libConfig::Bundle bundle;
+    BOOST_REQUIRE(bundle.initialize());
+    BOOST_CHECK(!bundle.hasConfigForTask("watched::Task"));
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::vector<std::string> changed;
+    libConfig::BundleWatcher watcher(bundle, 20);
+    watcher.subscribe([&](const std::vector<std::string>& tasks){
+        std::lock_guard<std::mutex> lock(mutex);
+        changed = tasks;
+        cond.notify_all();
+    });
+    BOOST_REQUIRE(watcher.start());
+
+    //New configuration file in a dependency is picked up
+    fs::path file = fs::path(bundle_path) / "third" / "config" / "orogen" / "watched::Task.yml";
+    std::ofstream os(file.string(), std::ios_base::out);
+    os << "--- name:default\n";
+    os << "name: watched\n";
+    os.close();
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        BOOST_REQUIRE(cond.wait_for(lock, std::chrono::seconds(5),
+                                    [&]{ return !changed.empty(); }));
+        BOOST_CHECK_EQUAL(changed.size(), 1);
+        BOOST_CHECK_EQUAL(changed[0], "watched::Task");
+        changed.clear();
+    }
+    libConfig::Configuration cfg = bundle.taskConfigurations.getConfig(
+                "watched::Task", {"default"});
+    std::shared_ptr<libConfig::SimpleConfigValue> val =
+            std::dynamic_pointer_cast<libConfig::SimpleConfigValue>(cfg.getValues().at("name"));
+    BOOST_CHECK_EQUAL(val->getValue(), "watched");
+    //The watcher keeps the file index up to date
+    BOOST_CHECK_EQUAL(bundle.getConfigurationPathsForTaskModel("watched::Task").size(), 1);
+
+    //Removing the file removes the task configuration
+    const libConfig::MultiSectionConfiguration& watched =
+            bundle.taskConfigurations.getMultiConfig("watched::Task");
+    fs::remove(file);
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        BOOST_REQUIRE(cond.wait_for(lock, std::chrono::seconds(5),
+                                    [&]{ return !changed.empty(); }));
+    }
+    BOOST_CHECK(!bundle.hasConfigForTask("watched::Task"));
+    //References taken before the reload still refer to the old configuration
+    BOOST_CHECK_EQUAL(watched.getSubsections().count("default"), 1);
+    BOOST_CHECK(bundle.hasConfigForTask("my::Task"));
+
+    //A bundle.yml that cannot be resolved keeps the previous state
+    fs::path bundleConfig = fs::path(bundle_path) / "third" / "config" / "bundle.yml";
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        changed.clear();
+    }
+    {
+        std::ofstream broken(bundleConfig.string());
+        broken << "bundle:\n    dependencies:\n        - watched_missing\n";
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    BOOST_CHECK(bundle.initialized());
+    BOOST_CHECK_EQUAL(bundle.getActiveBundles().size(), 4);
+    BOOST_CHECK(bundle.hasConfigForTask("my::Task"));
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        BOOST_CHECK(changed.empty());
+    }
+    //and the watches, so that the repaired file is picked up
+    std::ofstream(bundleConfig.string()).close();
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        BOOST_REQUIRE(cond.wait_for(lock, std::chrono::seconds(5),
+                                    [&]{ return !changed.empty(); }));
+        changed.clear();
+    }
+    BOOST_CHECK_EQUAL(bundle.getActiveBundles().size(), 4);
+    watcher.stop();
+}
+
+BOOST_AUTO_TEST_CASE(file_index)
+{
+    clear_environment_variables();
+    setenv("ROCK_BUNDLE_PATH", bundle_path.c_str(), 1);
+    setenv("ROCK_BUNDLE", "first", 1);
+    libConfig::Bundle bundle;
+    BOOST_REQUIRE(bundle.initialize());
+
+    std::vector<std::string> files = bundle.findFilesByName("config/orogen/my::Task.yml");
+    BOOST_REQUIRE_EQUAL(files.size(), 4);
+    BOOST_CHECK_EQUAL(files[0], bundle_path + "/first/config/orogen/my::Task.yml");
+    BOOST_CHECK_EQUAL(files[3], bundle_path + "/fourth/config/orogen/my::Task.yml");
+    BOOST_CHECK_EQUAL(bundle.findFilesByName("config").size(), 4);
+    BOOST_CHECK_THROW(bundle.findFileByName("config/orogen/missing::Task.yml"),
+                      std::runtime_error);
+
+    //Configuration files created after initialization are found after a
+    //refresh
+    fs::path file = fs::path(bundle_path) / "second" / "config" / "sub" / "file.txt";
+    fs::create_directories(file.parent_path());
+    std::ofstream(file.string()) << "data";
+    BOOST_CHECK(bundle.findFilesByName("config/sub/file.txt").empty());
+    bundle.refreshFileIndex("config/sub/file.txt");
+    BOOST_CHECK_EQUAL(bundle.findFileByName("config/sub/file.txt"), file.string());
+    BOOST_CHECK_EQUAL(bundle.findFileByName("./config//sub/file.txt"),
+                      bundle_path + "/second/./config//sub/file.txt");
+    std::vector<std::string> txt = bundle.findFilesByExtension("config", ".txt");
+    BOOST_REQUIRE_EQUAL(txt.size(), 1);
+    BOOST_CHECK_EQUAL(txt[0], file.string());
+    fs::remove(file);
+    bundle.refreshFileIndex();
+    BOOST_CHECK(bundle.findFilesByName("config/sub/file.txt").empty());
+
+    //Data directories and version control directories are not indexed,
+    //they are asked directly
+    fs::path data = fs::path(bundle_path) / "second" / "data" / "sub" / "file.txt";
+    fs::create_directories(data.parent_path());
+    std::ofstream(data.string()) << "data";
+    BOOST_CHECK_EQUAL(bundle.findFileByName("data/sub/file.txt"), data.string());
+    BOOST_CHECK_EQUAL(bundle.findFilesByExtension("data", ".txt").size(), 1);
+    //Scanned in the order of a serial walk of the bundles
+    for(const std::string& name : {"second", "third"}){
+        for(const std::string& sub : {"a/b/c", "a/d", "e"}){
+            fs::path dir = fs::path(bundle_path) / name / "data" / sub;
+            fs::create_directories(dir);
+            std::ofstream((dir / "file.txt").string()) << "data";
+            std::ofstream((dir / "file.bin").string()) << "data";
+        }
+    }
+    std::vector<std::string> walked;
+    for(const libConfig::SingleBundle& sb : bundle.getActiveBundles())
+    {
+        fs::path root = fs::path(sb.path) / "data";
+        if(!fs::is_directory(root)){
+            continue;
+        }
+        for(fs::recursive_directory_iterator it(root), end; it != end; ++it){
+            if(fs::is_regular_file(*it) && it->path().extension() == ".txt"){
+                walked.push_back(it->path().string());
+            }
+        }
+    }
+    std::vector<std::string> scanned = bundle.findFilesByExtension("data", ".txt");
+    BOOST_CHECK_EQUAL(walked.size(), 7);
+    BOOST_CHECK_EQUAL_COLLECTIONS(scanned.begin(), scanned.end(), walked.begin(), walked.end());
+    fs::remove_all(data.parent_path().parent_path());
+    fs::remove_all(fs::path(bundle_path) / "third" / "data");
+    libConfig::BundleFileIndex index;
+    index.build(bundle.getActiveBundles());
+    size_t indexSize = index.size();
+    fs::path vcs = fs::path(bundle_path) / "third" / "config" / ".git" / "objects" / "obj.yml";
+    fs::create_directories(vcs.parent_path());
+    std::ofstream(vcs.string()) << "vcs";
+    index.build(bundle.getActiveBundles());
+    BOOST_CHECK_EQUAL(index.size(), indexSize + 1);
+    BOOST_CHECK_EQUAL(index.find("config/.git/objects/obj.yml").size(), 1);
+    BOOST_CHECK_EQUAL(index.findByExtension("config/.git", ".yml").size(), 1);
+    fs::remove_all(vcs.parent_path().parent_path());
+
+    //Log directories are not indexed, they are asked directly
+    fs::path log = fs::path(bundle_path) / "third" / "logs" / "run.log";
+    std::ofstream(log.string()) << "log";
+    BOOST_CHECK_EQUAL(bundle.findFileByName("logs/run.log"), log.string());
+    BOOST_CHECK_EQUAL(bundle.findFilesByExtension("", ".log").size(), 1);
+    fs::remove(log);
+
+    //Optional files do not throw, failed probes notice new files
+    BOOST_CHECK(bundle.tryFindFileByName("config/missing.yml").empty());
+    BOOST_CHECK_THROW(bundle.findFileByName("config/missing.yml"), std::runtime_error);
+    BOOST_CHECK(bundle.tryFindFileByName("logs/sub/later.log").empty());
+    BOOST_CHECK(bundle.tryFindFileByName("logs/sub/later.log").empty());
+    fs::create_directory(log.parent_path() / "sub");
+    std::ofstream((log.parent_path() / "sub" / "later.log").string()) << "log";
+    BOOST_CHECK_EQUAL(bundle.tryFindFileByName("logs/sub/later.log"),
+                      (log.parent_path() / "sub" / "later.log").string());
+    fs::remove_all(log.parent_path() / "sub");
+
+    //Symlinked directories are resolved, but not descended for extensions
+    fs::path link = fs::path(bundle_path) / "first" / "linked";
+    fs::create_directory_symlink(fs::path(bundle_path) / "fourth" / "config", link);
+    bundle.refreshFileIndex();
+    BOOST_CHECK_EQUAL(bundle.findFileByName("linked/orogen/my::Task.yml"),
+                      link.string() + "/orogen/my::Task.yml");
+    BOOST_CHECK_EQUAL(bundle.findFilesByExtension("", ".yml").size(), 8);
+    BOOST_CHECK_EQUAL(bundle.findFilesByExtension("linked", ".yml").size(), 2);
+    fs::remove(link);
+}
+
+BOOST_AUTO_TEST_CASE(parallel_file_index)
+{
+    clear_environment_variables();
+    setenv("ROCK_BUNDLE_PATH", bundle_path.c_str(), 1);
+    setenv("ROCK_BUNDLE", "first", 1);
+    libConfig::Bundle bundle;
+    BOOST_REQUIRE(bundle.initialize(false));
+    for(int i = 0; i < 20; i++){
+        fs::path dir = fs::path(bundle_path) / "third" / "config" / "scan" / std::to_string(i);
+        fs::create_directories(dir);
+        std::ofstream((dir / "file.yml").string()) << "data";
+    }
+
+    //The result does not depend on the number of scanning threads
+    libConfig::BundleFileIndex serial;
+    serial.build(bundle.getActiveBundles(), 1);
+    libConfig::BundleFileIndex parallel;
+    parallel.build(bundle.getActiveBundles(), 8);
+    BOOST_CHECK_EQUAL(serial.size(), parallel.size());
+    std::vector<std::string> expected = serial.findByExtension("config", ".yml");
+    std::vector<std::string> files = parallel.findByExtension("config", ".yml");
+    BOOST_CHECK_EQUAL(files.size(), 28);
+    BOOST_CHECK_EQUAL_COLLECTIONS(files.begin(), files.end(), expected.begin(), expected.end());
+    //Files are grouped by bundle in priority order
+    BOOST_CHECK_NE(files.front().find("/first/"), std::string::npos);
+    BOOST_CHECK_NE(files.back().find("/fourth/"), std::string::npos);
+
+    fs::remove_all(fs::path(bundle_path) / "third" / "config" / "scan");
+}
+
+BOOST_AUTO_TEST_CASE(parallel_task_configuration_loading)
+{
+    clear_environment_variables();
+    setenv("ROCK_BUNDLE_PATH", bundle_path.c_str(), 1);
+    setenv("ROCK_BUNDLE", "first", 1);
+    libConfig::Bundle bundle;
+    BOOST_REQUIRE(bundle.initialize(false));
+    for(int i = 0; i < 10; i++){
+        fs::path file = fs::path(bundle_path) / "second" / "config" / "orogen" /
+                ("par" + std::to_string(i) + "::Task.yml");
+        std::ofstream os(file.string());
+        os << "--- name:default\nvalue: " << i << "\n";
+    }
+    bundle.refreshFileIndex();
+    std::vector<std::string> files = bundle.findFilesByExtension("config/orogen", ".yml");
+    BOOST_REQUIRE_EQUAL(files.size(), 14);
+
+    //Merging gives the same result for any number of threads
+    libConfig::TaskConfigurations serial;
+    serial.setLoaderThreads(1);
+    serial.initialize(files);
+    libConfig::TaskConfigurations parallel;
+    parallel.setLoaderThreads(8);
+    parallel.initialize(files);
+    BOOST_REQUIRE(serial.getTaskModelNames() == parallel.getTaskModelNames());
+    BOOST_CHECK_EQUAL(parallel.getTaskModelNames().size(), 11);
+    for(const std::string& task : serial.getTaskModelNames())
+    {
+        for(const auto& section : serial.getMultiConfig(task).getSubsections())
+        {
+            BOOST_CHECK(section.second ==
+                        parallel.getConfig(task, {section.first}));
+        }
+    }
+    //The highest priority bundle wins
+    libConfig::Configuration cfg = parallel.getConfig("my::Task", {"specialized"});
+    std::shared_ptr<libConfig::SimpleConfigValue> name =
+            std::dynamic_pointer_cast<libConfig::SimpleConfigValue>(cfg.getValues().at("name"));
+    BOOST_CHECK_EQUAL(name->getValue(), "first");
+
+    for(int i = 0; i < 10; i++){
+        fs::remove(fs::path(bundle_path) / "second" / "config" / "orogen" /
+                   ("par" + std::to_string(i) + "::Task.yml"));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(lazy_task_configuration_loading)
+{
+    clear_environment_variables();
+    setenv("ROCK_BUNDLE_PATH", bundle_path.c_str(), 1);
+    setenv("ROCK_BUNDLE", "first", 1);
+    libConfig::Bundle bundle;
+    BOOST_REQUIRE(bundle.initialize(false));
+    std::vector<std::string> files = bundle.findFilesByExtension("config/orogen", ".yml");
+
+    libConfig::TaskConfigurations eager;
+    eager.setLazyLoading(false);
+    eager.initialize(files);
+    libConfig::TaskConfigurations lazy;
+    lazy.setLazyLoading(true);
+    BOOST_CHECK(lazy.isLazyLoading());
+    lazy.initialize(files);
+
+    //Task models are known before any file is parsed
+    BOOST_CHECK(lazy.hasConfigForTask("my::Task"));
+    BOOST_CHECK(!lazy.hasConfigForTask("unknown::Task"));
+    BOOST_REQUIRE(eager.getTaskModelNames() == lazy.getTaskModelNames());
+    BOOST_CHECK_THROW(lazy.getConfig("unknown::Task", {"default"}), std::out_of_range);
+
+    for(const std::string& task : eager.getTaskModelNames())
+    {
+        for(const auto& section : eager.getMultiConfig(task).getSubsections())
+        {
+            BOOST_CHECK(section.second == lazy.getConfig(task, {section.first}));
+        }
+    }
+    //Loaded and pending task models are listed alike
+    BOOST_CHECK(eager.getTaskModelNames() == lazy.getTaskModelNames());
+
+    //Reloading a task that was not accessed yet only replaces its files
+    libConfig::TaskConfigurations reloaded;
+    reloaded.setLazyLoading(true);
+    reloaded.initialize(files);
+    BOOST_CHECK(reloaded.reloadTask("my::Task", {}));
+    BOOST_CHECK(!reloaded.hasConfigForTask("my::Task"));
+}
+
+BOOST_AUTO_TEST_CASE(concurrent_bundle_access)
+{
+    clear_environment_variables();
+    setenv("ROCK_BUNDLE_PATH", bundle_path.c_str(), 1);
+    setenv("ROCK_BUNDLE", "first", 1);
+    //Resolved by the threads loading the task configurations of the instance
+    fs::path insertionFile = fs::path(bundle_path) / "second" / "config" /
+            "orogen" / "insertion::Task.yml";
+    {
+        std::ofstream os(insertionFile.string());
+        os << "--- name:default\nfile: <%= BUNDLES('config/bundle.yml') %>\n";
+    }
+
+    //All threads get the same, completely initialized instance
+    libConfig::Bundle::deleteInstance();
+    std::vector<libConfig::Bundle*> instances(8, nullptr);
+    std::vector<std::thread> threads;
+    for(size_t i = 0; i < instances.size(); i++){
+        threads.emplace_back([&instances, i](){
+            libConfig::Bundle& b = libConfig::Bundle::getInstance();
+            if(b.hasConfigForTask("my::Task")){
+                instances[i] = &b;
+            }
+        });
+    }
+    for(std::thread& t : threads){
+        t.join();
+    }
+    for(libConfig::Bundle* b : instances){
+        BOOST_CHECK(b && b == instances.front());
+    }
+    libConfig::Bundle& inst = libConfig::Bundle::getInstance();
+    libConfig::Configuration cfg = inst.taskConfigurations.getConfig("insertion::Task", {"default"});
+    std::shared_ptr<libConfig::SimpleConfigValue> file =
+            std::dynamic_pointer_cast<libConfig::SimpleConfigValue>(cfg.getValues().at("file"));
+    BOOST_REQUIRE(file);
+    BOOST_CHECK_EQUAL(file->getValue(), bundle_path + "/first/config/bundle.yml");
+
+    //Readers always see a consistent state while the bundle is reloaded
+    const std::vector<libConfig::SingleBundle>& active = inst.getActiveBundles();
+    libConfig::SingleBundle& selected = inst.selectedBundle();
+    std::vector<std::string> myTaskFiles = inst.findFilesByName("config/orogen/my::Task.yml");
+    std::atomic<bool> done(false);
+    std::atomic<size_t> inconsistent(0);
+    threads.clear();
+    for(int i = 0; i < 4; i++){
+        threads.emplace_back([&](){
+            while(!done){
+                std::shared_ptr<const libConfig::BundleState> state = inst.getState();
+                std::shared_ptr<const libConfig::TaskConfigurationMap> configs =
+                        inst.taskConfigurations.getSnapshot();
+                if(state->activeBundles.size() != 4 || !state->fileIndex.isBuilt() ||
+                   inst.findFilesByName("config/bundle.yml").size() != 4 ||
+                   inst.getActiveBundles().size() != 4 ||
+                   configs->at("my::Task")->getSubsections().count("default") != 1){
+                    inconsistent++;
+                }
+            }
+        });
+    }
+    for(int i = 0; i < 5; i++){
+        BOOST_CHECK(inst.initialize(false));
+        inst.refreshFileIndex();
+        inst.refreshFileIndex("config/bundle.yml");
+        BOOST_CHECK(inst.taskConfigurations.reloadTask("my::Task", myTaskFiles));
+    }
+    done = true;
+    for(std::thread& t : threads){
+        t.join();
+    }
+    BOOST_CHECK_EQUAL(inconsistent, 0);
+    //Re-initializing with the same bundles keeps the returned references
+    BOOST_CHECK_EQUAL(&inst.getActiveBundles(), &active);
+    BOOST_CHECK_EQUAL(&inst.selectedBundle(), &selected);
+    BOOST_CHECK_EQUAL(selected.name, "first");
+
+    //Only a bounded number of replaced configurations is retained
+    const libConfig::MultiSectionConfiguration& reloaded =
+            inst.taskConfigurations.getMultiConfig("my::Task");
+    for(size_t i = 0; i < libConfig::TaskConfigurations::RETAINED_SNAPSHOTS; i++){
+        inst.taskConfigurations.reloadTask("my::Task", myTaskFiles);
+    }
+    BOOST_CHECK_EQUAL(reloaded.getSubsections().count("default"), 1);
+    size_t retained = inst.taskConfigurations.memoryUsage();
+    for(size_t i = 0; i < 2 * libConfig::TaskConfigurations::RETAINED_SNAPSHOTS; i++){
+        inst.taskConfigurations.reloadTask("my::Task", myTaskFiles);
+    }
+    BOOST_CHECK_EQUAL(inst.taskConfigurations.memoryUsage(), retained);
+
+    libConfig::Bundle::deleteInstance();
+    fs::remove(insertionFile);
+}
+
+BOOST_AUTO_TEST_CASE(dependency_resolution)
+{
+    //dep_a
+    //  |- dep_b
+    //       |- dep_d
+    //            |- dep_f
+    //  |- dep_c
+    //       |- dep_e
+    //       |- dep_a (cycle)
+    prepare_bundle("dep_a", {"dep_b", "dep_c"});
+    prepare_bundle("dep_b", {"dep_d"});
+    prepare_bundle("dep_c", {"dep_e", "dep_a"});
+    prepare_bundle("dep_d", {"dep_f"});
+    prepare_bundle("dep_e", {});
+    prepare_bundle("dep_f", {});
+    std::vector<std::string> searchPaths(1, bundle_path);
+    libConfig::SingleBundle root =
+            libConfig::SingleBundle::fromNameAndSearchPaths("dep_a", searchPaths);
+
+    libConfig::DependencyResolver resolver(4);
+    std::shared_ptr<const libConfig::BundleDependencyGraph> graph =
+            resolver.resolve(root, searchPaths);
+    //The direct dependencies of a bundle follow it, then the dependencies
+    //of each of them are resolved in turn
+    std::vector<std::string> names;
+    for(const libConfig::SingleBundle& b : graph->bundles){
+        names.push_back(b.name);
+    }
+    std::vector<std::string> expected = {"dep_a", "dep_b", "dep_c", "dep_d", "dep_f", "dep_e"};
+    BOOST_CHECK_EQUAL_COLLECTIONS(names.begin(), names.end(), expected.begin(), expected.end());
+    BOOST_CHECK(graph->bundles[3].path == bundle_path + "/dep_d");
+    BOOST_REQUIRE_EQUAL(graph->dependencies[2].size(), 2);
+    BOOST_CHECK_EQUAL(graph->dependencies[2][0], 5);
+    BOOST_CHECK_EQUAL(graph->dependencies[2][1], 0);
+    BOOST_REQUIRE_EQUAL(graph->cycles.size(), 1);
+    std::vector<std::string> cycle = {"dep_a", "dep_c", "dep_a"};
+    BOOST_CHECK(graph->cycles[0] == cycle);
+
+    //Unchanged bundles are answered from the cache
+    BOOST_CHECK(resolver.resolve(root, searchPaths) == graph);
+    BOOST_CHECK_EQUAL(resolver.getCacheHits(), 1);
+
+    //Modifying a bundle.yml invalidates the cached graph
+    prepare_bundle("dep_g", {});
+    prepare_bundle("dep_e", {"dep_g"});
+    graph = resolver.resolve(root, searchPaths);
+    BOOST_CHECK_EQUAL(resolver.getCacheHits(), 1);
+    BOOST_REQUIRE_EQUAL(graph->bundles.size(), 7);
+    BOOST_CHECK_EQUAL(graph->bundles.back().name, "dep_g");
+
+    //Missing dependencies are errors
+    prepare_bundle("dep_f", {"dep_missing"});
+    BOOST_CHECK_THROW(resolver.resolve(root, searchPaths), std::runtime_error);
+
+    for(const std::string& name : {"dep_a", "dep_b", "dep_c", "dep_d", "dep_e", "dep_f", "dep_g"}){
+        fs::remove_all(fs::path(bundle_path) / name);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(bundle_registry)
+{
+    const std::string otherPath = bundle_path + "_registry";
+    fs::remove_all(otherPath);
+    fs::create_directories(fs::path(otherPath) / "first");
+    fs::create_directories(fs::path(otherPath) / "other" / "config");
+    std::vector<std::string> searchPaths = {bundle_path, otherPath};
+
+    libConfig::BundleRegistry registry;
+    std::vector<std::string> names = registry.getBundleNames(searchPaths);
+    BOOST_CHECK_EQUAL(std::count(names.begin(), names.end(), "first"), 2);
+    BOOST_CHECK_EQUAL(std::count(names.begin(), names.end(), "other"), 1);
+    BOOST_CHECK_EQUAL(registry.getScanCount(), 2);
+
+    //The first search path wins, the records match the uncached resolution
+    for(const std::string& name : {"first", "other"})
+    {
+        libConfig::SingleBundle cached = registry.getBundle(name, searchPaths);
+        libConfig::SingleBundle probed =
+                libConfig::SingleBundle::fromNameAndSearchPaths(name, searchPaths);
+        BOOST_CHECK_EQUAL(cached.path, probed.path);
+        BOOST_CHECK_EQUAL(cached.configDir, probed.configDir);
+        BOOST_CHECK_EQUAL(cached.orogenConfigDir, probed.orogenConfigDir);
+        BOOST_CHECK_EQUAL(cached.dataDir, probed.dataDir);
+        BOOST_CHECK_EQUAL(cached.logBaseDir, probed.logBaseDir);
+    }
+    BOOST_CHECK_EQUAL(registry.getBundles(searchPaths).size(), names.size());
+    BOOST_CHECK_EQUAL(registry.getScanCount(), 2);
+    BOOST_CHECK_THROW(registry.getBundle("missing", searchPaths), std::runtime_error);
+
+    //Added bundles and directories are picked up
+    fs::create_directories(fs::path(otherPath) / "added");
+    fs::create_directories(fs::path(otherPath) / "other" / "data");
+    BOOST_CHECK_EQUAL(registry.getBundle("added", searchPaths).path, otherPath + "/added");
+    BOOST_CHECK_EQUAL(registry.getBundle("other", searchPaths).dataDir, otherPath + "/other/data");
+    BOOST_CHECK_EQUAL(registry.getScanCount(), 3);
+
+    //Search paths that do not exist or are files are skipped
+    const std::string missingPath = bundle_path + "_registry_missing";
+    const std::string filePath = otherPath + "/file";
+    fs::remove_all(missingPath);
+    std::ofstream(filePath.c_str()) << "no search path";
+    std::vector<std::string> staleSearchPaths = {missingPath, filePath, otherPath};
+    BOOST_CHECK_EQUAL(registry.getBundle("other", staleSearchPaths).path, otherPath + "/other");
+    BOOST_CHECK_EQUAL(registry.getBundleNames(staleSearchPaths).size(), 3);
+    size_t scanCount = registry.getScanCount();
+    BOOST_CHECK_THROW(registry.getBundle("missing", staleSearchPaths), std::runtime_error);
+    BOOST_CHECK_EQUAL(registry.getScanCount(), scanCount);
+    //and listed once they are created
+    fs::create_directories(fs::path(missingPath) / "other");
+    BOOST_CHECK_EQUAL(registry.getBundle("other", staleSearchPaths).path, missingPath + "/other");
+
+    fs::remove_all(missingPath);
+    fs::remove_all(otherPath);
+}
+
+BOOST_AUTO_TEST_CASE(resolved_deployment)
+{
+    clear_environment_variables();
+    setenv("ROCK_BUNDLE_PATH", bundle_path.c_str(), 1);
+    setenv("ROCK_BUNDLE", "first", 1);
+    libConfig::Bundle bundle;
+    bundle.taskConfigurations.setLazyLoading(true);
+    BOOST_REQUIRE(bundle.initialize(true));
+
+    std::vector<libConfig::DeploymentEntry> entries =
+            libConfig::ResolvedDeployment::parseDescription(
+                "my::Task: [default, specialized]\n"
+                "other:\n"
+                "    model: my::Task\n"
+                "    sections: [default, first]\n"
+                "plain:\n"
+                "    model: my::Task\n");
+    BOOST_REQUIRE_EQUAL(entries.size(), 3);
+    BOOST_CHECK_EQUAL(entries[0].taskModelName, "my::Task");
+    BOOST_CHECK(entries[2].sections == std::vector<std::string>{"default"});
+
+    libConfig::ResolvedDeployment resolved;
+    resolved.resolve(bundle.taskConfigurations, entries, 4);
+    for(const libConfig::DeploymentEntry& entry : entries){
+        BOOST_CHECK(resolved.getConfig(entry.name) ==
+                    bundle.taskConfigurations.getConfig(entry.taskModelName, entry.sections));
+    }
+
+    //The written file loads without a bundle and with the same content
+    const std::string path = bundle_path + "/resolved.yml";
+    resolved.save(path);
+    libConfig::ResolvedDeployment loaded;
+    loaded.load(path);
+    BOOST_REQUIRE_EQUAL(loaded.getEntries().size(), entries.size());
+    for(const libConfig::DeploymentEntry& entry : entries)
+    {
+        BOOST_CHECK(loaded.getConfig(entry.name) == resolved.getConfig(entry.name));
+        BOOST_CHECK_EQUAL(loaded.getConfig(entry.name).getName(),
+                          resolved.getConfig(entry.name).getName());
+    }
+    BOOST_CHECK_EQUAL(loaded.getEntries()[1].taskModelName, "my::Task");
+    BOOST_CHECK_THROW(loaded.getConfig("missing"), std::out_of_range);
+
+    //It is also a regular multi section file
+    libConfig::MultiSectionConfiguration multi;
+    multi.loadNoBundle(path);
+    BOOST_CHECK(multi.getConfig({"other"}) == resolved.getConfig("other"));
+
+    BOOST_CHECK_THROW(resolved.resolve(bundle.taskConfigurations,
+                      libConfig::ResolvedDeployment::parseDescription("unknown::Task: [default]")),
+                      std::out_of_range);
+    BOOST_CHECK_THROW(libConfig::ResolvedDeployment::parseDescription("- my::Task"),
+                      std::runtime_error);
+    fs::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(synthetic_bundles)
+{
+    libConfig::SyntheticBundleSpec spec;
+    spec.bundles = 5;
+    spec.dependencyDepth = 2;
+    spec.taskFiles = 3;
+    spec.sectionsPerFile = 2;
+    spec.propertiesPerSection = 8;
+    spec.arraySize = 4;
+    const std::string root = bundle_path + "_synthetic";
+    libConfig::SyntheticBundles generated = libConfig::generateSyntheticBundles(root, spec);
+
+    //All bundles are reachable from the selected one. The search paths of
+    //Bundle are fixed for the process, so the hierarchy is resolved directly.
+    std::vector<std::string> searchPaths = {generated.searchPath};
+    libConfig::DependencyResolver resolver;
+    std::shared_ptr<const libConfig::BundleDependencyGraph> graph = resolver.resolve(
+            libConfig::SingleBundle::fromNameAndSearchPaths(generated.selected, searchPaths),
+            searchPaths);
+    BOOST_REQUIRE_EQUAL(graph->bundles.size(), spec.bundles);
+    BOOST_CHECK(graph->cycles.empty());
+
+    std::vector<std::string> files;
+    for(const libConfig::SingleBundle& b : graph->bundles){
+        for(const std::string& task : generated.taskModels){
+            files.push_back(b.orogenConfigDir + "/" + task + ".yml");
+            BOOST_CHECK(fs::exists(files.back()));
+        }
+    }
+    libConfig::TaskConfigurations configs;
+    configs.setLazyLoading(false);
+    configs.initialize(files);
+    BOOST_CHECK(configs.getTaskModelNames() == generated.taskModels);
+
+    //The selected bundle has the highest priority, insertions are resolved
+    libConfig::Configuration config =
+            configs.getConfig(generated.taskModels[0], generated.sections);
+    BOOST_CHECK_EQUAL(config.getValues().size(), spec.propertiesPerSection);
+    std::shared_ptr<libConfig::SimpleConfigValue> inserted =
+            std::dynamic_pointer_cast<libConfig::SimpleConfigValue>(config.getValues().at("prop_0"));
+    BOOST_REQUIRE(inserted);
+    BOOST_CHECK_EQUAL(inserted->getValue(), "synthetic/0");
+    std::shared_ptr<libConfig::ArrayConfigValue> array =
+            std::dynamic_pointer_cast<libConfig::ArrayConfigValue>(config.getValues().at("prop_2"));
+    BOOST_REQUIRE(array);
+    BOOST_CHECK_EQUAL(array->getValues().size(), spec.arraySize);
+
+    fs::remove_all(root);
+}
+
+size_t count_nodes(const libConfig::ConfigValue& value)
+{
+    size_t count = 1;
+    if(value.getType() == libConfig::ConfigValue::COMPLEX){
+        for(const auto& it : static_cast<const libConfig::ComplexConfigValue&>(value).getValues()){
+            count += count_nodes(*it.second);
+        }
+    }else if(value.getType() == libConfig::ConfigValue::ARRAY){
+        for(const auto& v : static_cast<const libConfig::ArrayConfigValue&>(value).getValues()){
+            count += count_nodes(*v);
+        }
+    }
+    return count;
+}
+
+BOOST_AUTO_TEST_CASE(task_configuration_memory)
+{
+    libConfig::SyntheticBundleSpec spec;
+    spec.bundles = 3;
+    spec.taskFiles = 4;
+    const std::string root = bundle_path + "_memory";
+    libConfig::SyntheticBundles generated = libConfig::generateSyntheticBundles(root, spec);
+    std::vector<std::string> files;
+    for(const std::string& bundle : generated.bundles){
+        for(const std::string& task : generated.taskModels){
+            files.push_back(root + "/" + bundle + "/config/orogen/" + task + ".yml");
+        }
+    }
+    auto load = [&files](libConfig::TaskConfigurations& configs){
+        configs.setLazyLoading(false);
+        configs.setLoaderThreads(1);
+        configs.initialize(files);
+    };
+    {
+        //Warms up static state of the parser, which is never freed
+        libConfig::TaskConfigurations configs;
+        load(configs);
+    }
+
+    //The heap counter measures requested sizes on this thread, which is
+    //independent of the allocator and of other threads. Loading with one
+    //thread keeps all allocations on it.
+    libConfig::HeapCounter::Scope total(libConfig::HeapCounter::Scope::THREAD);
+    {
+        libConfig::HeapCounter::Scope loading(libConfig::HeapCounter::Scope::THREAD);
+        libConfig::TaskConfigurations configs;
+        load(configs);
+        long retained = loading.delta().liveBytes;
+        size_t estimated = configs.memoryUsage();
+        BOOST_TEST_MESSAGE("Loaded task configurations retain " << retained <<
+                           " bytes, estimated " << estimated);
+        BOOST_CHECK_GT(estimated, retained * 0.98);
+        BOOST_CHECK_LT(estimated, retained * 1.02);
+
+        libConfig::HeapCounter::Scope merging(libConfig::HeapCounter::Scope::THREAD);
+        libConfig::Configuration config =
+                configs.getConfig(generated.taskModels[0], generated.sections);
+        size_t nodes = 0;
+        for(const auto& it : config.getValues()){
+            nodes += count_nodes(*it.second);
+        }
+        //Each section is merged into the result
+        BOOST_CHECK_LE(merging.delta().allocations, 2 * nodes * generated.sections.size());
+        BOOST_CHECK_GT(config.memoryUsage(), merging.delta().liveBytes * 0.98);
+        BOOST_CHECK_LT(config.memoryUsage(), merging.delta().liveBytes * 1.02);
+    }
+    //Nothing is left behind
+    BOOST_CHECK_EQUAL(total.delta().liveBytes, 0);
+    fs::remove_all(root);
+}
+
+BOOST_AUTO_TEST_CASE(benchmark_comparison)
+{
+    libConfig::BenchmarkRun baseline;
+    baseline.results.push_back(libConfig::BenchmarkResult::fromSamples(
+                                   "parse", 10, {3e-3, 1e-3, 2e-3, 4e-3, 5e-3}));
+    baseline.results.back().allocations = 100;
+    baseline.results.push_back(libConfig::BenchmarkResult::fromSamples(
+                                   "merge", 1, {1e-3}));
+    const libConfig::BenchmarkResult& parse = baseline.results[0];
+    BOOST_CHECK_CLOSE(parse.median, 3e-3, 1e-6);
+    BOOST_CHECK_CLOSE(parse.p25, 2e-3, 1e-6);
+    BOOST_CHECK_CLOSE(parse.p90, 4.6e-3, 1e-6);
+    BOOST_CHECK_CLOSE(parse.mean, 3e-3, 1e-6);
+
+    //Results survive the JSON round trip
+    const std::string path = bundle_path + "_baseline.json";
+    baseline.save(path);
+    libConfig::BenchmarkRun loaded = libConfig::BenchmarkRun::load(path);
+    fs::remove(path);
+    BOOST_REQUIRE_EQUAL(loaded.results.size(), 2);
+    BOOST_CHECK_EQUAL(loaded.results[0].name, "parse");
+    BOOST_CHECK_EQUAL(loaded.results[0].iterations, 10);
+    BOOST_CHECK_CLOSE(loaded.results[0].p90, parse.p90, 1e-6);
+    BOOST_CHECK_EQUAL(loaded.results[0].allocations, 100);
+    BOOST_CHECK_EQUAL(loaded.spec.taskFiles, baseline.spec.taskFiles);
+    BOOST_CHECK_EQUAL(loaded.filter, "");
+
+    std::stringstream out;
+    libConfig::BenchmarkTolerance tolerance;
+    BOOST_CHECK(libConfig::compareBenchmarkRuns(baseline, loaded, tolerance, out));
+
+    //Slower within the tolerance
+    libConfig::BenchmarkRun current = loaded;
+    current.results[0].median *= 1.05;
+    BOOST_CHECK(libConfig::compareBenchmarkRuns(baseline, current, tolerance, out));
+
+    //Missing benchmarks fail, unless the run was filtered and excluded them
+    current.results.pop_back();
+    BOOST_CHECK(!libConfig::compareBenchmarkRuns(baseline, current, tolerance, out));
+    BOOST_CHECK_NE(out.str().find("MISSING"), std::string::npos);
+    current.filter = "merge";
+    BOOST_CHECK(!libConfig::compareBenchmarkRuns(baseline, current, tolerance, out));
+    current.filter = "pars";
+    current.save(path);
+    current = libConfig::BenchmarkRun::load(path);
+    fs::remove(path);
+    BOOST_CHECK_EQUAL(current.filter, "pars");
+    BOOST_CHECK(libConfig::compareBenchmarkRuns(baseline, current, tolerance, out));
+    BOOST_CHECK_NE(out.str().find("filtered"), std::string::npos);
+
+    current.results[0].median = parse.median * 1.5;
+    BOOST_CHECK(!libConfig::compareBenchmarkRuns(baseline, current, tolerance, out));
+    tolerance.time = 0.6;
+    BOOST_CHECK(libConfig::compareBenchmarkRuns(baseline, current, tolerance, out));
+    current.results[0].allocations = 120;
+    BOOST_CHECK(!libConfig::compareBenchmarkRuns(baseline, current, tolerance, out));
+    BOOST_CHECK_NE(out.str().find("REGRESSION (allocations)"), std::string::npos);
+
+    current.spec.bundles++;
+    BOOST_CHECK_THROW(libConfig::compareBenchmarkRuns(baseline, current, tolerance, out),
+                      std::runtime_error);
+}
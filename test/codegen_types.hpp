@@ -0,0 +1,36 @@
+#ifndef CODEGEN_TYPES_H
+#define CODEGEN_TYPES_H
+
+#include <cstdint>
+
+//Types the test suite generates decoders for with lib_config_codegen.
+//codegen_types.tlb is their Typelib model.
+namespace codegen_test
+{
+
+enum Mode
+{
+    MODE_A = 0,
+    MODE_B = 5,
+};
+
+struct Gains
+{
+    double p;
+    double d;
+};
+
+struct Config
+{
+    double d;
+    int32_t i;
+    Mode mode;
+    uint8_t flag;
+    float values[3];
+    Gains gains;
+    Gains limits[2];
+};
+
+}
+
+#endif // CODEGEN_TYPES_H
@@ -0,0 +1,151 @@
+#include "heap_counter.hpp"
+#include "LoadMetrics.hpp"
+#include <atomic>
+#include <new>
+#include <cstdlib>
+#include <cstddef>
+
+using namespace libConfig;
+
+namespace
+{
+std::atomic<size_t> allocationCount(0);
+std::atomic<size_t> allocatedBytes(0);
+std::atomic<long> liveBytes(0);
+thread_local size_t threadAllocationCount = 0;
+thread_local size_t threadAllocatedBytes = 0;
+thread_local long threadLiveBytes = 0;
+
+//Every block is prefixed with its requested size, so that the counts do not
+//depend on the rounding of the allocator
+const size_t HEADER_SIZE = alignof(std::max_align_t);
+
+void* countedAlloc(size_t size)
+{
+    void* block = malloc(HEADER_SIZE + size);
+    if(!block){
+        return nullptr;
+    }
+    *static_cast<size_t*>(block) = size;
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    liveBytes.fetch_add(size, std::memory_order_relaxed);
+    threadAllocationCount++;
+    threadAllocatedBytes += size;
+    threadLiveBytes += size;
+    return static_cast<char*>(block) + HEADER_SIZE;
+}
+
+void countedFree(void* p)
+{
+    if(p){
+        void* block = static_cast<char*>(p) - HEADER_SIZE;
+        size_t size = *static_cast<size_t*>(block);
+        liveBytes.fetch_sub(size, std::memory_order_relaxed);
+        threadLiveBytes -= size;
+        free(block);
+    }
+}
+}
+
+void* operator new(size_t size)
+{
+    void* p = countedAlloc(size);
+    if(!p){
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return countedAlloc(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return countedAlloc(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    countedFree(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    countedFree(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    countedFree(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+    countedFree(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept
+{
+    countedFree(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept
+{
+    countedFree(p);
+}
+
+HeapUsage::HeapUsage() :
+    allocations(0), allocatedBytes(0), liveBytes(0)
+{
+}
+
+HeapUsage HeapCounter::current()
+{
+    HeapUsage usage;
+    usage.allocations = allocationCount.load(std::memory_order_relaxed);
+    usage.allocatedBytes = allocatedBytes.load(std::memory_order_relaxed);
+    usage.liveBytes = liveBytes.load(std::memory_order_relaxed);
+    return usage;
+}
+
+HeapUsage HeapCounter::currentThread()
+{
+    HeapUsage usage;
+    usage.allocations = threadAllocationCount;
+    usage.allocatedBytes = threadAllocatedBytes;
+    usage.liveBytes = threadLiveBytes;
+    return usage;
+}
+
+size_t HeapCounter::allocations()
+{
+    return allocationCount.load(std::memory_order_relaxed);
+}
+
+void HeapCounter::install()
+{
+    LoadMetrics::setAllocationCounter(&HeapCounter::allocations);
+}
+
+HeapCounter::Scope::Scope(Range range) :
+    range(range), start(range == THREAD ? currentThread() : current())
+{
+}
+
+HeapUsage HeapCounter::Scope::delta() const
+{
+    HeapUsage now = range == THREAD ? currentThread() : current();
+    HeapUsage ret;
+    ret.allocations = now.allocations - start.allocations;
+    ret.allocatedBytes = now.allocatedBytes - start.allocatedBytes;
+    ret.liveBytes = now.liveBytes - start.liveBytes;
+    return ret;
+}
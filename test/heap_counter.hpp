@@ -0,0 +1,56 @@
+#ifndef HEAP_COUNTER_H
+#define HEAP_COUNTER_H
+
+#include <cstddef>
+
+namespace libConfig
+{
+
+struct HeapUsage
+{
+    size_t allocations;
+    //Requested size of the allocated blocks, without allocator rounding
+    size_t allocatedBytes;
+    //Allocated minus freed bytes
+    long liveBytes;
+
+    HeapUsage();
+};
+
+/**
+ * @brief Counts the heap allocations of the process
+ * Linking heap_counter.cpp replaces the global operator new and delete with
+ * versions that count every allocation of any thread. Blocks are counted
+ * with their requested size, so the numbers are the same for any malloc
+ * implementation. Over-aligned allocations are not counted.
+ */
+class HeapCounter
+{
+public:
+    static HeapUsage current();
+    //Allocations made and blocks freed by the calling thread
+    static HeapUsage currentThread();
+    static size_t allocations();
+    //Makes LoadMetrics report allocation counts
+    static void install();
+
+    //Heap usage since construction
+    class Scope
+    {
+    public:
+        enum Range {
+            PROCESS,
+            //Only the calling thread, not disturbed by other threads
+            THREAD,
+        };
+        explicit Scope(Range range = PROCESS);
+        HeapUsage delta() const;
+    private:
+        Range range;
+        HeapUsage start;
+    };
+};
+
+}
+
+#endif // HEAP_COUNTER_H
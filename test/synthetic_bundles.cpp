@@ -0,0 +1,124 @@
+#include "synthetic_bundles.hpp"
+#include <boost/filesystem.hpp>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+
+namespace fs = boost::filesystem;
+using namespace libConfig;
+
+namespace
+{
+const char* INSERTION_VARIABLE = "LIB_CONFIG_SYNTHETIC_VALUE";
+
+std::string bundleName(size_t idx)
+{
+    return "synthetic_" + std::to_string(idx);
+}
+
+std::string sectionName(size_t idx)
+{
+    return idx == 0 ? "default" : "section_" + std::to_string(idx);
+}
+
+//Level of each bundle in the dependency hierarchy, the selected bundle is
+//the only one on level 0
+size_t bundleLevel(const SyntheticBundleSpec& spec, size_t idx)
+{
+    if(idx == 0 || spec.dependencyDepth == 0){
+        return 0;
+    }
+    return 1 + (idx - 1) % spec.dependencyDepth;
+}
+}
+
+SyntheticBundleSpec::SyntheticBundleSpec() :
+    bundles(4), dependencyDepth(2), taskFiles(10), sectionsPerFile(5),
+    propertiesPerSection(20), arraySize(8), insertionsPerSection(1)
+{
+}
+
+std::string libConfig::syntheticSection(const SyntheticBundleSpec &spec, size_t bundle,
+                                        size_t section)
+{
+    std::stringstream ss;
+    for(size_t p = 0; p < spec.propertiesPerSection; p++)
+    {
+        ss << "prop_" << p << ":";
+        if(p < spec.insertionsPerSection){
+            ss << " <%= ENV('" << INSERTION_VARIABLE << "') %>/" << bundle << "\n";
+            continue;
+        }
+        switch(p % 4){
+            case 0:
+                ss << " " << bundle * 1000 + section * 10 + p << "\n";
+                break;
+            case 1:
+                ss << " text_" << bundle << "_" << section << "_" << p << "\n";
+                break;
+            case 2:
+                ss << " [";
+                for(size_t i = 0; i < spec.arraySize; i++){
+                    ss << (i ? ", " : "") << bundle + i * 0.5;
+                }
+                ss << "]\n";
+                break;
+            case 3:
+                ss << "\n  x: " << bundle << "\n  y: " << section + 0.25 <<
+                      "\n  name: nested_" << p << "\n";
+                break;
+        }
+    }
+    return ss.str();
+}
+
+SyntheticBundles libConfig::generateSyntheticBundles(const std::string &root,
+                                                     const SyntheticBundleSpec &spec)
+{
+    setenv(INSERTION_VARIABLE, "synthetic", 1);
+    boost::system::error_code ec;
+    fs::remove_all(root, ec);
+    fs::create_directories(root);
+
+    SyntheticBundles ret;
+    ret.searchPath = root;
+    ret.selected = bundleName(0);
+    for(size_t t = 0; t < spec.taskFiles; t++){
+        ret.taskModels.push_back("synthetic::Task" + std::to_string(t));
+    }
+    for(size_t s = 0; s < spec.sectionsPerFile; s++){
+        ret.sections.push_back(sectionName(s));
+    }
+
+    for(size_t b = 0; b < spec.bundles; b++)
+    {
+        ret.bundles.push_back(bundleName(b));
+        fs::path bundleRoot = fs::path(root) / bundleName(b);
+        fs::create_directories(bundleRoot / "config" / "orogen");
+        fs::create_directory(bundleRoot / "data");
+
+        std::ofstream bundleYml((bundleRoot / "config" / "bundle.yml").string());
+        std::vector<std::string> deps;
+        for(size_t d = 1; d < spec.bundles; d++){
+            if(bundleLevel(spec, d) == bundleLevel(spec, b) + 1){
+                deps.push_back(bundleName(d));
+            }
+        }
+        if(!deps.empty()){
+            bundleYml << "bundle:\n    dependencies:\n";
+            for(const std::string& dep : deps){
+                bundleYml << "        - " << dep << "\n";
+            }
+        }
+
+        for(const std::string& task : ret.taskModels)
+        {
+            std::ofstream taskYml((bundleRoot / "config" / "orogen" / (task + ".yml")).string());
+            for(size_t s = 0; s < spec.sectionsPerFile; s++){
+                taskYml << "--- name:" << sectionName(s) << "\n" <<
+                           syntheticSection(spec, b, s);
+            }
+        }
+    }
+    return ret;
+}
@@ -0,0 +1,60 @@
+#ifndef SYNTHETIC_BUNDLES_H
+#define SYNTHETIC_BUNDLES_H
+
+#include <string>
+#include <vector>
+
+namespace libConfig
+{
+
+/**
+ * @brief Shape of a generated bundle hierarchy
+ */
+struct SyntheticBundleSpec
+{
+    size_t bundles;
+    //Number of dependency levels below the selected bundle. The other
+    //bundles are spread over the levels, each bundle depends on all bundles
+    //of the next level.
+    size_t dependencyDepth;
+    //Task model files in each bundle, every bundle configures the same task
+    //models so that they are merged
+    size_t taskFiles;
+    size_t sectionsPerFile;
+    size_t propertiesPerSection;
+    size_t arraySize;
+    //Properties per section that use an <%= ENV(...) %> insertion
+    size_t insertionsPerSection;
+
+    SyntheticBundleSpec();
+};
+
+struct SyntheticBundles
+{
+    //Value for ROCK_BUNDLE_PATH
+    std::string searchPath;
+    //Value for ROCK_BUNDLE, the bundle at the top of the hierarchy
+    std::string selected;
+    std::vector<std::string> bundles;
+    std::vector<std::string> taskModels;
+    std::vector<std::string> sections;
+};
+
+/**
+ * @brief Writes a bundle hierarchy of the given shape into root
+ * root is removed first. Sets the environment variable used by the
+ * insertions of the generated files.
+ */
+SyntheticBundles generateSyntheticBundles(const std::string& root,
+                                          const SyntheticBundleSpec& spec);
+
+/**
+ * @brief YAML text of a single section, as written into the task files
+ * The values depend on the bundle index, so sections of different bundles
+ * override each other when merged.
+ */
+std::string syntheticSection(const SyntheticBundleSpec& spec, size_t bundle, size_t section);
+
+}
+
+#endif // SYNTHETIC_BUNDLES_H
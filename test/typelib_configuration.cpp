@@ -0,0 +1,512 @@
+#include <boost/test/unit_test.hpp>
+#include "TypelibConfiguration.hpp"
+#include "YAMLConfiguration.hpp"
+#include "ConfigurationValidator.hpp"
+#include "TypelibPlan.hpp"
+#include "CodeGenerator.hpp"
+#include "ConfigDecoder.hpp"
+//Generated by lib_config_codegen from codegen_types.tlb
+#include "codegen_types_decoder.hpp"
+#include "Bundle.hpp"
+#include <typelib/typemodel.hh>
+#include <typelib/registry.hh>
+#include <fstream>
+#include <cstddef>
+#include <cstring>
+#include <sstream>
+
+namespace
+{
+enum TestMode
+{
+    MODE_A = 0,
+    MODE_B = 5,
+};
+
+struct TestStruct
+{
+    double d;
+    int32_t i;
+    TestMode mode;
+    uint8_t flag;
+    float values[3];
+};
+
+//Typelib model of TestStruct
+struct TestTypes
+{
+    Typelib::Numeric doubleT;
+    Typelib::Numeric int32T;
+    Typelib::Numeric uint8T;
+    Typelib::Numeric floatT;
+    Typelib::Enum modeT;
+    Typelib::Array valuesT;
+    Typelib::Compound structT;
+
+    TestTypes() :
+        doubleT("/double", sizeof(double), Typelib::Numeric::Float),
+        int32T("/int32_t", sizeof(int32_t), Typelib::Numeric::SInt),
+        uint8T("/uint8_t", sizeof(uint8_t), Typelib::Numeric::UInt),
+        floatT("/float", sizeof(float), Typelib::Numeric::Float),
+        modeT("/TestMode"),
+        valuesT(floatT, 3),
+        structT("/TestStruct")
+    {
+        modeT.add("MODE_A", MODE_A);
+        modeT.add("MODE_B", MODE_B);
+        structT.addField("d", doubleT, offsetof(TestStruct, d));
+        structT.addField("i", int32T, offsetof(TestStruct, i));
+        structT.addField("mode", modeT, offsetof(TestStruct, mode));
+        structT.addField("flag", uint8T, offsetof(TestStruct, flag));
+        structT.addField("values", valuesT, offsetof(TestStruct, values));
+        structT.setSize(sizeof(TestStruct));
+    }
+};
+
+//Typelib model of codegen_test::Config, the same as in codegen_types.tlb
+struct CodegenTypes
+{
+    Typelib::Numeric doubleT;
+    Typelib::Numeric int32T;
+    Typelib::Numeric uint8T;
+    Typelib::Numeric floatT;
+    Typelib::Enum modeT;
+    Typelib::Array valuesT;
+    Typelib::Compound gainsT;
+    Typelib::Array limitsT;
+    Typelib::Compound configT;
+
+    CodegenTypes() :
+        doubleT("/double", sizeof(double), Typelib::Numeric::Float),
+        int32T("/int32_t", sizeof(int32_t), Typelib::Numeric::SInt),
+        uint8T("/uint8_t", sizeof(uint8_t), Typelib::Numeric::UInt),
+        floatT("/float", sizeof(float), Typelib::Numeric::Float),
+        modeT("/codegen_test/Mode"),
+        valuesT(floatT, 3),
+        gainsT("/codegen_test/Gains"),
+        limitsT(gainsT, 2),
+        configT("/codegen_test/Config")
+    {
+        using namespace codegen_test;
+        modeT.add("MODE_A", MODE_A);
+        modeT.add("MODE_B", MODE_B);
+        gainsT.addField("p", doubleT, offsetof(Gains, p));
+        gainsT.addField("d", doubleT, offsetof(Gains, d));
+        gainsT.setSize(sizeof(Gains));
+        configT.addField("d", doubleT, offsetof(Config, d));
+        configT.addField("i", int32T, offsetof(Config, i));
+        configT.addField("mode", modeT, offsetof(Config, mode));
+        configT.addField("flag", uint8T, offsetof(Config, flag));
+        configT.addField("values", valuesT, offsetof(Config, values));
+        configT.addField("gains", gainsT, offsetof(Config, gains));
+        configT.addField("limits", limitsT, offsetof(Config, limits));
+        configT.setSize(sizeof(Config));
+    }
+};
+
+std::shared_ptr<libConfig::ConfigValue> parse(const std::string& yml)
+{
+    libConfig::YAMLConfigParser parser;
+    return parser.getConfigValue(yml);
+}
+}
+
+BOOST_AUTO_TEST_CASE(get_from_value)
+{
+    TestTypes types;
+    TestStruct data;
+    memset(&data, 0, sizeof(data));
+    data.d = 0.1;
+    data.i = -42;
+    data.mode = MODE_B;
+    data.flag = 1;
+    data.values[0] = 0.1f;
+    data.values[1] = 1e20f;
+    Typelib::Value value(&data, types.structT);
+    libConfig::TypelibConfiguration conv;
+
+    std::shared_ptr<libConfig::ComplexConfigValue> config =
+            std::dynamic_pointer_cast<libConfig::ComplexConfigValue>(conv.getFromValue(value));
+    BOOST_REQUIRE(config);
+    BOOST_CHECK_EQUAL(config->getCxxTypeName(), "/TestStruct");
+    BOOST_REQUIRE_EQUAL(config->getValues().size(), 5);
+
+    auto scalar = [](const std::shared_ptr<libConfig::ConfigValue>& v){
+        return std::dynamic_pointer_cast<libConfig::SimpleConfigValue>(v)->getValue();
+    };
+    //Numbers are written in their shortest round-trip form
+    BOOST_CHECK_EQUAL(scalar(config->getValues().at("d")), "0.1");
+    BOOST_CHECK_EQUAL(scalar(config->getValues().at("i")), "-42");
+    BOOST_CHECK_EQUAL(scalar(config->getValues().at("mode")), "MODE_B");
+    BOOST_CHECK_EQUAL(scalar(config->getValues().at("flag")), "1");
+    BOOST_CHECK_EQUAL(config->getValues().at("flag")->getName(), "flag");
+
+    std::shared_ptr<libConfig::ArrayConfigValue> values =
+            std::dynamic_pointer_cast<libConfig::ArrayConfigValue>(config->getValues().at("values"));
+    BOOST_REQUIRE(values);
+    BOOST_REQUIRE_EQUAL(values->getValues().size(), 3);
+    BOOST_CHECK_EQUAL(scalar(values->getValues()[0]), "0.1");
+    BOOST_CHECK_EQUAL(scalar(values->getValues()[1]), "1e+20");
+    BOOST_CHECK_EQUAL(scalar(values->getValues()[2]), "0");
+}
+
+BOOST_AUTO_TEST_CASE(apply_to_value)
+{
+    TestTypes types;
+    TestStruct data;
+    memset(&data, 0, sizeof(data));
+    Typelib::Value value(&data, types.structT);
+    libConfig::TypelibConfiguration conv;
+
+    conv.applyToValue(*parse("d: 1.5\ni: -3\nmode: :MODE_B\nflag: true\nvalues: [1, 2]"), value);
+    BOOST_CHECK_EQUAL(data.d, 1.5);
+    BOOST_CHECK_EQUAL(data.i, -3);
+    BOOST_CHECK_EQUAL(data.mode, MODE_B);
+    BOOST_CHECK_EQUAL(data.flag, 1);
+    BOOST_CHECK_EQUAL(data.values[0], 1);
+    BOOST_CHECK_EQUAL(data.values[1], 2);
+    BOOST_CHECK_EQUAL(data.values[2], 0);
+
+    //Fields that are not configured keep their value
+    conv.applyToValue(*parse("i: 7"), value);
+    BOOST_CHECK_EQUAL(data.i, 7);
+    BOOST_CHECK_EQUAL(data.d, 1.5);
+
+    //Converting back and forth gives the same value
+    TestStruct copy;
+    memset(&copy, 0, sizeof(copy));
+    Typelib::Value copyValue(&copy, types.structT);
+    conv.applyToValue(*conv.getFromValue(value), copyValue);
+    BOOST_CHECK_EQUAL(memcmp(&copy, &data, sizeof(data)), 0);
+
+    BOOST_CHECK_THROW(conv.applyToValue(*parse("unknown: 1"), value), std::runtime_error);
+    BOOST_CHECK_THROW(conv.applyToValue(*parse("mode: MODE_C"), value), std::runtime_error);
+    BOOST_CHECK_THROW(conv.applyToValue(*parse("i: 3000000000"), value), std::runtime_error);
+    BOOST_CHECK_THROW(conv.applyToValue(*parse("flag: 256"), value), std::runtime_error);
+    BOOST_CHECK_THROW(conv.applyToValue(*parse("d: abc"), value), std::runtime_error);
+    BOOST_CHECK_THROW(conv.applyToValue(*parse("values: [1, 2, 3, 4]"), value), std::runtime_error);
+    BOOST_CHECK_THROW(conv.applyToValue(*parse("values: 1"), value), std::runtime_error);
+
+    //Properties of a Configuration are applied to the fields of a compound
+    libConfig::Configuration cfg("default");
+    cfg.addValue("i", std::make_shared<libConfig::SimpleConfigValue>("12"));
+    conv.applyToValue(cfg, value);
+    BOOST_CHECK_EQUAL(data.i, 12);
+}
+
+BOOST_AUTO_TEST_CASE(update_from_value)
+{
+    TestTypes types;
+    TestStruct data;
+    memset(&data, 0, sizeof(data));
+    Typelib::Value value(&data, types.structT);
+    libConfig::TypelibConfiguration conv;
+
+    std::shared_ptr<libConfig::ConfigValue> config = conv.getFromValue(value);
+    std::shared_ptr<libConfig::ComplexConfigValue> complex =
+            std::dynamic_pointer_cast<libConfig::ComplexConfigValue>(config);
+    std::shared_ptr<libConfig::ConfigValue> iNode = complex->getValues().at("i");
+    BOOST_CHECK(!conv.updateFromValue(value, *config));
+
+    data.i = 17;
+    data.values[2] = 2.5;
+    BOOST_CHECK(conv.updateFromValue(value, *config));
+    //Nodes are reused
+    BOOST_CHECK_EQUAL(complex->getValues().at("i").get(), iNode.get());
+    BOOST_CHECK(*config == *conv.getFromValue(value));
+    BOOST_CHECK(!conv.updateFromValue(value, *config));
+
+    libConfig::SimpleConfigValue simple("1");
+    BOOST_CHECK_THROW(conv.updateFromValue(value, simple), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(write_yaml)
+{
+    TestTypes types;
+    TestStruct data;
+    memset(&data, 0, sizeof(data));
+    data.d = 0.1;
+    data.i = -42;
+    data.mode = MODE_B;
+    data.flag = 1;
+    data.values[1] = 1e20f;
+    Typelib::Value value(&data, types.structT);
+    libConfig::TypelibConfiguration conv;
+
+    std::stringstream ss;
+    conv.writeYaml(value, ss);
+    //Fields are written in declaration order
+    BOOST_CHECK_EQUAL(ss.str(), "d: 0.1\ni: -42\nmode: MODE_B\nflag: 1\nvalues: [0, 1e+20, 0]");
+    //The output reads back to the same configuration as getFromValue
+    BOOST_CHECK(*parse(ss.str()) == *conv.getFromValue(value));
+
+    data.mode = static_cast<TestMode>(3);
+    std::stringstream invalid;
+    BOOST_CHECK_THROW(conv.writeYaml(value, invalid), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(matches_value)
+{
+    TestTypes types;
+    TestStruct data;
+    memset(&data, 0, sizeof(data));
+    data.d = 1;
+    data.i = 7;
+    data.mode = MODE_B;
+    data.values[0] = 0.1f;
+    Typelib::Value value(&data, types.structT);
+    libConfig::TypelibConfiguration conv;
+
+    //Numbers are compared numerically, unconfigured fields are ignored
+    BOOST_CHECK(conv.matchesValue(*parse("d: 1.0\ni: 7\nmode: :MODE_B\nflag: false\nvalues: [0.1]"), value));
+    BOOST_CHECK(conv.matchesValue(*conv.getFromValue(value), value));
+
+    std::shared_ptr<libConfig::ConfigValue> config = parse("d: 2\ni: 7\nmode: MODE_A\nvalues: [0.1, 1]");
+    BOOST_CHECK(!conv.matchesValue(*config, value));
+
+    std::vector<std::string> differences;
+    BOOST_CHECK(!conv.matchesValue(*config, value, &differences));
+    BOOST_REQUIRE_EQUAL(differences.size(), 1);
+    BOOST_CHECK_EQUAL(differences[0], "d: configured 2, value is 1");
+
+    differences.clear();
+    BOOST_CHECK(!conv.matchesValue(*config, value, &differences, true));
+    BOOST_REQUIRE_EQUAL(differences.size(), 3);
+    BOOST_CHECK_EQUAL(differences[1], "mode: configured MODE_A, value is MODE_B");
+    BOOST_CHECK_EQUAL(differences[2], "values[1]: configured 1, value is 0");
+
+    BOOST_CHECK_THROW(conv.matchesValue(*parse("unknown: 1"), value), std::runtime_error);
+    BOOST_CHECK_THROW(conv.matchesValue(*parse("i: abc"), value), std::runtime_error);
+
+    libConfig::Configuration cfg("default");
+    cfg.addValue("i", std::make_shared<libConfig::SimpleConfigValue>("7"));
+    BOOST_CHECK(conv.matchesValue(cfg, value));
+}
+
+BOOST_AUTO_TEST_CASE(validate_task_configurations)
+{
+    Typelib::Registry registry;
+    Typelib::Numeric* int8T = new Typelib::Numeric("/int8_t", 1, Typelib::Numeric::SInt);
+    Typelib::Enum* modeT = new Typelib::Enum("/TestMode");
+    modeT->add("MODE_A", MODE_A);
+    Typelib::Compound* configT = new Typelib::Compound("/Config");
+    configT->addField("value", *int8T, 0);
+    configT->addField("mode", *modeT, 4);
+    configT->setSize(8);
+    registry.add(int8T);
+    registry.add(modeT);
+    registry.add(configT);
+
+    std::string file = "/tmp/validator::Task.yml";
+    std::ofstream fs(file.c_str());
+    fs << "--- name:default\n";
+    fs << "config:\n  value: 1\n  mode: MODE_A\n";
+    fs << "--- name:broken\n";
+    fs << "config:\n  value: 200\n  mode: MODE_C\n  other: 1\n";
+    fs << "unknown: 1\n";
+    fs << "untyped: 1\n";
+    fs.close();
+
+    libConfig::TaskConfigurations configs;
+    configs.initialize({file});
+
+    libConfig::ConfigurationValidator validator(registry);
+    validator.addTaskModel("validator::Task", {{"config", "/Config"}, {"untyped", "/Missing"}});
+    std::vector<libConfig::ValidationError> errors = validator.validate(configs, 2);
+    BOOST_REQUIRE_EQUAL(errors.size(), 5);
+    for(const libConfig::ValidationError& e : errors){
+        BOOST_CHECK_EQUAL(e.taskModelName, "validator::Task");
+        BOOST_CHECK_EQUAL(e.section, "broken");
+    }
+    BOOST_CHECK_EQUAL(errors[0].message, "Property 'config': Cannot apply configuration to "
+                      "'mode': 'MODE_C' is not a symbol of enum /TestMode");
+    BOOST_CHECK_EQUAL(errors[1].message, "Property 'config': Cannot apply configuration to "
+                      "'other': type /Config has no such field");
+    BOOST_CHECK_EQUAL(errors[2].message, "Property 'config': Cannot apply configuration to "
+                      "'value': 200 is out of range");
+    BOOST_CHECK_EQUAL(errors[3].message, "Task model has no property 'unknown'");
+    BOOST_CHECK_EQUAL(errors[4].message, "Type /Missing of property 'untyped' is not in the registry");
+
+    //Files that fail to load on first access are reported as errors
+    std::string brokenFile = "/tmp/validator::Broken.yml";
+    unsetenv("LIB_CONFIG_VALIDATOR_UNSET");
+    fs.open(brokenFile.c_str());
+    fs << "--- name:default\nconfig: <%= #{ENV['LIB_CONFIG_VALIDATOR_UNSET']} %>\n";
+    fs.close();
+    libConfig::TaskConfigurations lazy;
+    lazy.setLazyLoading(true);
+    lazy.initialize({file, brokenFile});
+    validator.addTaskModel("validator::Broken", {{"config", "/Config"}});
+    errors = validator.validate(lazy, 2);
+    BOOST_REQUIRE_EQUAL(errors.size(), 6);
+    BOOST_CHECK_EQUAL(errors[0].taskModelName, "validator::Broken");
+    BOOST_CHECK_EQUAL(errors[0].section, "");
+
+    remove(file.c_str());
+    remove(brokenFile.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(typelib_plan_cache)
+{
+    Typelib::Registry registry;
+    Typelib::Numeric* int32T = new Typelib::Numeric("/int32_t", sizeof(int32_t),
+                                                    Typelib::Numeric::SInt);
+    Typelib::Array* arrayT = new Typelib::Array(*int32T, 2);
+    registry.add(int32T);
+    registry.add(arrayT);
+
+    //Types of the registry are compiled once, nested types included
+    libConfig::TypelibPlanCache cache(registry);
+    std::shared_ptr<const libConfig::TypelibPlan> plan = cache.get(*arrayT);
+    BOOST_CHECK_EQUAL(plan->kind, libConfig::TypelibPlan::ARRAY);
+    BOOST_CHECK_EQUAL(plan->element->kind, libConfig::TypelibPlan::INT32);
+    BOOST_CHECK_EQUAL(cache.get(*arrayT), plan);
+    BOOST_CHECK_EQUAL(cache.get(*int32T).get(), plan->element);
+    BOOST_CHECK_EQUAL(cache.size(), 2);
+
+    //Types of the same name that are not in the registry are not cached
+    {
+        Typelib::Numeric otherT("/int32_t", sizeof(int16_t), Typelib::Numeric::SInt);
+        std::shared_ptr<const libConfig::TypelibPlan> other = cache.get(otherT);
+        BOOST_CHECK_EQUAL(other->kind, libConfig::TypelibPlan::INT16);
+        BOOST_CHECK(cache.get(otherT) != other);
+        BOOST_CHECK_EQUAL(cache.size(), 2);
+    }
+
+    //Held plans outlive clear()
+    cache.clear();
+    BOOST_CHECK_EQUAL(cache.size(), 0);
+    BOOST_CHECK_EQUAL(plan->element->kind, libConfig::TypelibPlan::INT32);
+    BOOST_CHECK(cache.get(*arrayT) != plan);
+
+    //Converters with a registry use its cache
+    int32_t data[2] = {3, -4};
+    Typelib::Value value(data, *arrayT);
+    libConfig::TypelibConfiguration conv(registry);
+    std::shared_ptr<libConfig::ArrayConfigValue> array =
+            std::dynamic_pointer_cast<libConfig::ArrayConfigValue>(conv.getFromValue(value));
+    BOOST_REQUIRE(array);
+    BOOST_REQUIRE_EQUAL(array->getValues().size(), 2);
+    std::shared_ptr<libConfig::SimpleConfigValue> last =
+            std::dynamic_pointer_cast<libConfig::SimpleConfigValue>(array->getValues()[1]);
+    BOOST_REQUIRE(last);
+    BOOST_CHECK_EQUAL(last->getValue(), "-4");
+}
+
+BOOST_AUTO_TEST_CASE(code_generator)
+{
+    BOOST_CHECK_EQUAL(libConfig::CodeGenerator::cxxTypeName("/base/Angle"), "base::Angle");
+    BOOST_CHECK_EQUAL(libConfig::CodeGenerator::cxxTypeName("/std/vector</base/Angle>"),
+                      "std::vector<base::Angle>");
+
+    Typelib::Registry registry;
+    Typelib::Numeric* int32T = new Typelib::Numeric("/int32_t", 4, Typelib::Numeric::SInt);
+    Typelib::Enum* modeT = new Typelib::Enum("/test/Mode");
+    modeT->add("MODE_A", 0);
+    Typelib::Compound* configT = new Typelib::Compound("/test/Config");
+    configT->addField("value", *int32T, 0);
+    configT->addField("mode", *modeT, 4);
+    configT->setSize(8);
+    registry.add(int32T);
+    registry.add(modeT);
+    registry.add(configT);
+
+    libConfig::CodeGenerator generator(registry);
+    generator.addInclude("test/Config.hpp");
+    generator.addType("/test/Config");
+    BOOST_CHECK_THROW(generator.addType("/test/Unknown"), std::runtime_error);
+
+    std::string code = generator.generate();
+    BOOST_CHECK(code.find("#include <test/Config.hpp>") != std::string::npos);
+    //Enums are generated before the structs using them
+    size_t enumPos = code.find("struct ConfigDecoder< ::test::Mode>");
+    size_t structPos = code.find("struct ConfigDecoder< ::test::Config>");
+    BOOST_REQUIRE(enumPos != std::string::npos);
+    BOOST_REQUIRE(structPos != std::string::npos);
+    BOOST_CHECK(enumPos < structPos);
+    BOOST_CHECK(code.find("decodeConfigValue(config, out.value, &fieldPath);") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(generated_decoder)
+{
+    //The generated specialization decodes the same as applyToValue
+    CodegenTypes types;
+    libConfig::TypelibConfiguration conv;
+    libConfig::Configuration cfg("default");
+    cfg.addValue("d", parse("1.5"));
+    cfg.addValue("mode", parse(":MODE_B"));
+    cfg.addValue("flag", parse("true"));
+    cfg.addValue("values", parse("[1, 2]"));
+    cfg.addValue("gains", parse("{p: 0.5, d: 0.25}"));
+    cfg.addValue("limits", parse("[{d: 3}, {p: -1, d: 4}]"));
+
+    codegen_test::Config decoded;
+    codegen_test::Config applied;
+    memset(&decoded, 0, sizeof(decoded));
+    memset(&applied, 0, sizeof(applied));
+    //Fields that are not configured keep their value
+    decoded.i = applied.i = 42;
+    decoded.values[2] = applied.values[2] = 7;
+
+    libConfig::decodeConfig(cfg, decoded);
+    Typelib::Value value(&applied, types.configT);
+    conv.applyToValue(cfg, value);
+    BOOST_CHECK_EQUAL(memcmp(&decoded, &applied, sizeof(decoded)), 0);
+    BOOST_CHECK_EQUAL(decoded.i, 42);
+    BOOST_CHECK_EQUAL(decoded.mode, codegen_test::MODE_B);
+    BOOST_CHECK_EQUAL(decoded.values[1], 2);
+    BOOST_CHECK_EQUAL(decoded.values[2], 7);
+    BOOST_CHECK_EQUAL(decoded.gains.d, 0.25);
+    BOOST_CHECK_EQUAL(decoded.limits[0].p, 0);
+    BOOST_CHECK_EQUAL(decoded.limits[1].d, 4);
+
+    //Both reject the same configurations
+    const char* invalid[] = {"unknown: 1", "mode: MODE_C", "i: 3000000000",
+                             "gains: {i: 1}", "limits: [{}, {}, {}]"};
+    for(const char* yml : invalid)
+    {
+        BOOST_CHECK_THROW(libConfig::decodeConfig(*parse(yml), decoded), std::runtime_error);
+        BOOST_CHECK_THROW(conv.applyToValue(*parse(yml), value), std::runtime_error);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(config_decoder)
+{
+    int32_t i = 0;
+    libConfig::decodeConfig(*parse("12"), i);
+    BOOST_CHECK_EQUAL(i, 12);
+    BOOST_CHECK_THROW(libConfig::decodeConfig(*parse("3000000000"), i), std::runtime_error);
+
+    //Standard types besides the fixed width typedefs
+    char c = 0;
+    libConfig::decodeConfig(*parse("65"), c);
+    BOOST_CHECK_EQUAL(c, 'A');
+    long long ll = 0;
+    libConfig::decodeConfig(*parse("-9000000000"), ll);
+    BOOST_CHECK_EQUAL(ll, -9000000000LL);
+    unsigned long long ull = 0;
+    BOOST_CHECK_THROW(libConfig::decodeConfig(*parse("-1"), ull), std::runtime_error);
+    long double ld = 0;
+    libConfig::decodeConfig(*parse("0.5"), ld);
+    BOOST_CHECK_EQUAL(ld, 0.5L);
+
+    std::vector<double> v;
+    libConfig::decodeConfig(*parse("[1, 2.5]"), v);
+    BOOST_REQUIRE_EQUAL(v.size(), 2);
+    BOOST_CHECK_EQUAL(v[1], 2.5);
+
+    std::vector<bool> flags;
+    libConfig::decodeConfig(*parse("[true, false]"), flags);
+    BOOST_REQUIRE_EQUAL(flags.size(), 2);
+    BOOST_CHECK(flags[0] && !flags[1]);
+
+    float values[3] = {0, 0, 7};
+    libConfig::decodeConfig(*parse("[1, 2]"), values);
+    BOOST_CHECK_EQUAL(values[1], 2);
+    BOOST_CHECK_EQUAL(values[2], 7);
+    BOOST_CHECK_THROW(libConfig::decodeConfig(*parse("[1, 2, 3, 4]"), values), std::runtime_error);
+
+    std::string str;
+    libConfig::decodeConfig(*parse("hello"), str);
+    BOOST_CHECK_EQUAL(str, "hello");
+}
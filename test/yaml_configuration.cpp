@@ -2,6 +2,9 @@
 #include <boost/filesystem.hpp>
 #include <iostream>
 #include "YAMLConfiguration.hpp"
+#include "LoadMetrics.hpp"
+#include "LoadTrace.hpp"
+#include "AccessTracker.hpp"
 #include <string>
 #include <map>
 #include <fstream>
@@ -41,6 +44,109 @@ BOOST_AUTO_TEST_CASE(load_from_file)
     BOOST_CHECK_EQUAL(configs.size(), 3);
 }
 
+BOOST_AUTO_TEST_CASE(load_metrics)
+{
+    std::string filepath = prepare_config_file();
+    libConfig::YAMLConfigParser parser;
+    std::map<std::string, libConfig::Configuration> configs;
+
+    //Nothing is recorded while disabled
+    libConfig::LoadMetrics::reset();
+    parser.loadConfigFile(filepath, configs);
+    BOOST_CHECK(libConfig::LoadMetrics::getReport().files.empty());
+
+    libConfig::LoadMetrics::setEnabled(true);
+    parser.loadConfigFile(filepath, configs);
+    libConfig::LoadMetrics::setEnabled(false);
+
+    libConfig::LoadMetricsReport report = libConfig::LoadMetrics::getReport();
+    BOOST_REQUIRE_EQUAL(report.files.size(), 1);
+    const libConfig::FileLoadMetrics& file = report.files[0];
+    BOOST_CHECK_EQUAL(file.path, filepath);
+    BOOST_CHECK_EQUAL(file.bytesRead, fs::file_size(filepath));
+    BOOST_REQUIRE_EQUAL(file.sections.size(), 3);
+    BOOST_CHECK_EQUAL(file.sections[0].name, "default");
+    //axisScale and name, the empty array has no children
+    BOOST_CHECK_EQUAL(file.sections[0].nodeCount, 2);
+    //axisScale with three elements and name
+    BOOST_CHECK_EQUAL(file.sections[1].nodeCount, 5);
+    BOOST_CHECK_EQUAL(file.nodeCount, 12);
+    BOOST_CHECK(file.loadTime > 0);
+    BOOST_CHECK_NE(report.toJson().find("\"name\": \"specialized\""), std::string::npos);
+    libConfig::LoadMetrics::reset();
+}
+
+BOOST_AUTO_TEST_CASE(load_trace)
+{
+    std::string filepath = prepare_config_file();
+    libConfig::LoadTrace::reset();
+    libConfig::LoadTrace::setEnabled(true);
+    libConfig::MultiSectionConfiguration mcfg;
+    mcfg.loadFromBundle(filepath);
+    mcfg.getConfig({"default", "specialized"});
+    libConfig::LoadTrace::setEnabled(false);
+
+    std::string json = libConfig::LoadTrace::toJson();
+    BOOST_CHECK_NE(json.find("\"traceEvents\""), std::string::npos);
+    BOOST_CHECK_NE(json.find("\"name\": \"MultiSectionConfiguration::loadFromBundle\""), std::string::npos);
+    BOOST_CHECK_NE(json.find("\"name\": \"MultiSectionConfiguration::getConfig\""), std::string::npos);
+    BOOST_CHECK_NE(json.find("\"detail\": \"" + filepath + "\""), std::string::npos);
+    libConfig::LoadTrace::reset();
+}
+
+BOOST_AUTO_TEST_CASE(access_tracking)
+{
+    std::string filepath = (fs::path("/tmp/") / "access::Task.yml").string();
+    std::ofstream fout(filepath);
+    fout << "--- name:default\n";
+    fout << "name: defaultname\n";
+    fout << "transform:\n  translation: [1,2,3]\n  rotation: [0,0,0,1]\n";
+    fout << "unused: 1\n";
+    fout << "--- name:other\n";
+    fout << "name: other\n";
+    fout.close();
+
+    libConfig::AccessTracker::reset();
+    libConfig::AccessTracker::setEnabled(true);
+    libConfig::MultiSectionConfiguration mcfg;
+    mcfg.loadFromBundle(filepath);
+    libConfig::AccessTracker::taskModelsLoaded({"access::Task", "never::Requested"});
+    libConfig::Configuration config = mcfg.getConfig({"default"});
+
+    //Writing the configuration is no read
+    BOOST_CHECK(!config.toYaml().empty());
+    libConfig::AccessReport report = libConfig::AccessTracker::getReport();
+    BOOST_CHECK_EQUAL(report.properties, 5);
+    BOOST_CHECK_EQUAL(report.usedProperties, 0);
+
+    const auto& values = config.getValues();
+    std::static_pointer_cast<libConfig::SimpleConfigValue>(values.at("name"))->getValue();
+    std::shared_ptr<libConfig::ComplexConfigValue> transform =
+            std::static_pointer_cast<libConfig::ComplexConfigValue>(values.at("transform"));
+    std::shared_ptr<libConfig::ArrayConfigValue> translation =
+            std::static_pointer_cast<libConfig::ArrayConfigValue>(transform->getValues().at("translation"));
+    std::static_pointer_cast<libConfig::SimpleConfigValue>(translation->getValues()[0])->getValue();
+    libConfig::AccessTracker::setEnabled(false);
+
+    report = libConfig::AccessTracker::getReport();
+    BOOST_CHECK_EQUAL(report.usedProperties, 3);
+    BOOST_REQUIRE_EQUAL(report.unusedTaskModels.size(), 1);
+    BOOST_CHECK_EQUAL(report.unusedTaskModels[0], "never::Requested");
+    BOOST_REQUIRE_EQUAL(report.unusedSections["access::Task"].size(), 1);
+    BOOST_CHECK_EQUAL(report.unusedSections["access::Task"][0], "other");
+    std::vector<std::string> unused = report.unusedProperties["access::Task"]["default"];
+    BOOST_REQUIRE_EQUAL(unused.size(), 2);
+    BOOST_CHECK_EQUAL(unused[0], "transform.rotation");
+    BOOST_CHECK_EQUAL(unused[1], "unused");
+    BOOST_CHECK_NE(report.toYaml().find("transform.rotation"), std::string::npos);
+
+    //Reads are not recorded while disabled
+    values.at("unused")->getType();
+    std::static_pointer_cast<libConfig::SimpleConfigValue>(values.at("unused"))->getValue();
+    BOOST_CHECK_EQUAL(libConfig::AccessTracker::getReport().usedProperties, 3);
+    libConfig::AccessTracker::reset();
+}
+
 BOOST_AUTO_TEST_CASE(load_from_string)
 {
     std::string filepath = prepare_config_file();